@@ -34,5 +34,12 @@ namespace VsChromium.Core.Ipc.TypedMessages {
 
     [ProtoMember(8)]
     public bool UseRe2Engine { get; set; }
+
+    /// <summary>
+    /// If greater than 0, the number of errors (inserted, deleted or
+    /// substituted characters) allowed in the matches of the search string.
+    /// </summary>
+    [ProtoMember(9)]
+    public int MaxErrors { get; set; }
   }
 }
@@ -2,10 +2,26 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+using System;
+using System.Threading;
+
 namespace VsChromium.Core.Utility {
   public interface IOperationProgressTracker {
     bool ShouldEndProcessing { get; }
     int ResultCount { get; }
+    /// <summary>
+    /// Cancelled when the operation is cancelled, e.g. to stop long running
+    /// native searches.
+    /// </summary>
+    CancellationToken CancellationToken { get; }
+    /// <summary>
+    /// Pointer to a native flag set to a non-zero value when <see
+    /// cref="CancellationToken"/> is cancelled, passed to the native searches
+    /// of the operation so that they stop without waiting for the next
+    /// match, or <see cref="IntPtr.Zero"/> if the operation cannot be
+    /// cancelled.
+    /// </summary>
+    IntPtr CancelledFlag { get; }
 
     void AddResults(int count);
   }
@@ -2,18 +2,31 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+using System;
+using System.Runtime.InteropServices;
 using System.Threading;
+using VsChromium.Core.Win32.Memory;
 
 namespace VsChromium.Core.Utility {
-  public class OperationProgressTracker : IOperationProgressTracker {
+  public class OperationProgressTracker : IOperationProgressTracker, IDisposable {
     public static IOperationProgressTracker None = new NullOperationProgressTracker();
 
     private readonly TaskResultCounter _resultCounter;
     private readonly CancellationToken _cancellationToken;
+    private readonly SafeHGlobalHandle _cancelledFlag;
+    private readonly CancellationTokenRegistration _cancellationRegistration;
 
     public OperationProgressTracker(int maxResults, CancellationToken cancellationToken) {
       _resultCounter = new TaskResultCounter(maxResults);
       _cancellationToken = cancellationToken;
+      // The flag is set once for the whole operation, instead of registering
+      // a callback for each native search.
+      if (cancellationToken.CanBeCanceled) {
+        _cancelledFlag = new SafeHGlobalHandle(Marshal.AllocHGlobal(sizeof(int)));
+        var flag = _cancelledFlag.Pointer;
+        Marshal.WriteInt32(flag, 0);
+        _cancellationRegistration = cancellationToken.Register(() => Marshal.WriteInt32(flag, 1));
+      }
     }
 
     public bool ShouldEndProcessing {
@@ -24,10 +37,27 @@ namespace VsChromium.Core.Utility {
       get { return _resultCounter.Count; }
     }
 
+    public CancellationToken CancellationToken {
+      get { return _cancellationToken; }
+    }
+
+    public IntPtr CancelledFlag {
+      get { return _cancelledFlag == null ? IntPtr.Zero : _cancelledFlag.Pointer; }
+    }
+
     public void AddResults(int count) {
       _resultCounter.Add(count);
     }
 
+    /// <summary>
+    /// Must be called once the native searches of the operation are done.
+    /// </summary>
+    public void Dispose() {
+      _cancellationRegistration.Dispose();
+      if (_cancelledFlag != null)
+        _cancelledFlag.Dispose();
+    }
+
     public class NullOperationProgressTracker : IOperationProgressTracker {
       public bool ShouldEndProcessing {
         get { return false; }
@@ -35,6 +65,10 @@ namespace VsChromium.Core.Utility {
 
       public int ResultCount { get { return 0; } }
 
+      public CancellationToken CancellationToken { get { return CancellationToken.None; } }
+
+      public IntPtr CancelledFlag { get { return IntPtr.Zero; } }
+
       public void AddResults(int count) {
       }
     }
@@ -9,14 +9,33 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
-#include <locale>
-
+#include <chrono>
+#include <vector>
+
+#include "byte_frequency.h"
+#include "compiled_pattern_cache.h"
+#include "corpus_sample.h"
+#include "cpu_features.h"
+#include "line_extent.h"
+#include "search_approximate.h"
 #include "search_bndm32.h"
 #include "search_bndm64.h"
+#include "search_bndm_long.h"
 #include "search_boyer_moore.h"
+#include "search_case_folding.h"
+#include "search_multi_literal.h"
+#include "search_simd_literal.h"
+#include "search_streaming.h"
 #include "search_strstr.h"
+#include "search_strstr_sse42.h"
+#include "search_two_way.h"
+#include "search_utf16_bndm.h"
+#include "search_utf16_simd.h"
+#include "search_utf8_case_folding.h"
+#include "search_wildcard.h"
 #include "search_regex.h"
 #include "search_re2.h"
 
@@ -24,56 +43,6 @@
 
 namespace {
 
-template<class CharType>
-bool GetLineExtentFromPosition(
-    const CharType* text,
-    int textLen,
-    int position,
-    int maxOffset,
-    int* lineStartPosition,
-    int* lineLen) {
-  const CharType nl = '\n';
-  const CharType* low = max(text, text + position - maxOffset);
-  const CharType* high = min(text + textLen, text + position + maxOffset);
-  const CharType* current = text + position;
-
-  // Search backward up to "low" included
-  const CharType* start = current;
-  if (start > low) {
-    start--;
-    for (; start >= low; start--) {
-      if (*start == nl) {
-        break;
-      }
-    }
-    start++;
-  }
-
-  // Search forward up to "high" excluded
-  const CharType* end = current;
-  for (; end < high; end++) {
-    if (*end == nl) {
-      end++;
-      break;
-    }
-  }
-
-  assert(low <= start);
-  assert(start <= high);
-  assert(low <= end);
-  assert(end <= high);
-
-  // TODO(rpaquay): We are limited to 2GB for now.
-  *lineStartPosition = static_cast<int>(start - text);
-  *lineLen = static_cast<int>(end - start);
-  return true;
-}
-
-bool char_equal_icase(wchar_t x , wchar_t y) {
-  static const std::locale& loc(std::locale::classic());
-  return std::tolower(x, loc) == std::tolower(y, loc);
-}
-
 bool Text_HasUtf8Bom(const char *text, int textLen) {
   return textLen >= 3 &&
     static_cast<uint8_t>(text[0]) == static_cast<uint8_t>(0xEF) &&
@@ -144,6 +113,8 @@ struct ContentResult {
   int utf8Count;
   // Count others (i.e. not in previous 2 categories)
   int otherCount;
+  // Occurrences of each simple ascii character
+  ByteCounts byteCounts;
 };
 
 void Text_ContentKindFull(const char* text, int textLen, ContentResult& result) {
@@ -154,6 +125,7 @@ void Text_ContentKindFull(const char* text, int textLen, ContentResult& result)
     // See http://www.asciitable.com/
     if ((ch >= 32 && ch <= 126) || ch == '\t' || ch == '\r' || ch == '\n') {
       result.asciiCount++;
+      result.byteCounts.counts[ch]++;
       textPtr++;
       textLen--;
     }
@@ -191,7 +163,7 @@ void Text_ContentKindSlices(const char* text, int textLen, ContentResult& result
   }
 }
 
-ContentKindResult ContentResultToContentKindResult(ContentResult contentResult) {
+ContentKindResult ContentResultToContentKindResult(const ContentResult& contentResult) {
   int total = contentResult.asciiCount + contentResult.utf8Count + contentResult.otherCount;
   double otherRatio = (double)contentResult.otherCount / (double)total;
 
@@ -211,7 +183,15 @@ ContentKindResult Text_ContentKind(const char* text, int textLen) {
 #if 1
   ContentResult contentResult;
   Text_ContentKindSlices(text, textLen, contentResult);
-  return ContentResultToContentKindResult(contentResult);
+  ContentKindResult result = ContentResultToContentKindResult(contentResult);
+  // Text files contribute to the byte frequencies used to select the bytes
+  // searches are anchored on (see |GetRarestByteOffsets|), and to the sample
+  // used to select the fastest search algorithm.
+  if (result != ResultBinary) {
+    AddCorpusByteCounts(contentResult.byteCounts);
+    AddCorpusSample(text, textLen);
+  }
+  return result;
 #else
   ContentResult contentResult1;
   Text_ContentKindFull(text, textLen, contentResult1);
@@ -227,6 +207,125 @@ ContentKindResult Text_ContentKind(const char* text, int textLen) {
 #endif
 }
 
+bool UseCaseFoldingSearch(AsciiSearchBase::SearchOptions options, int patternLen) {
+  return (options & AsciiSearchBase::kMatchCase) == 0 &&
+    (options & AsciiSearchBase::kPerByteCaseFolding) == 0 &&
+    patternLen <= CaseFoldingSearch::kMaxPatternLength;
+}
+
+template <typename T, typename W>
+using SimdLiteralSearchSse2 = SimdLiteralSearch<T, W, Sse2Vector>;
+template <typename T, typename W>
+using SimdLiteralSearchAvx2 = SimdLiteralSearch<T, W, Avx2Vector>;
+template <typename T, typename W>
+using Utf16SimdSearchSse2 = Utf16SimdSearch<T, W, Sse2Vector>;
+template <typename T, typename W>
+using Utf16SimdSearchAvx2 = Utf16SimdSearch<T, W, Avx2Vector>;
+template <typename T, typename W>
+using ApproximateSearchSse2 = ApproximateSearch<T, W, Sse2Vector>;
+template <typename T, typename W>
+using ApproximateSearchAvx2 = ApproximateSearch<T, W, Avx2Vector>;
+
+enum SearchKernel {
+  kKernelBndm32,
+  kKernelBndm64,
+  kKernelBndmLong,
+  kKernelBoyerMoore,
+  kKernelTwoWay,
+  kKernelSimdLiteralSse2,
+  kKernelSimdLiteralAvx2,
+  kKernelUtf16Bndm,
+  kKernelUtf16SimdSse2,
+  kKernelUtf16SimdAvx2,
+  kKernelApproximateSse2,
+  kKernelApproximateAvx2,
+  kKernelCount
+};
+
+typedef AsciiSearchBase* (*CreateSearchKernelFunction)();
+
+template <typename S>
+AsciiSearchBase* CreateSearchKernel() {
+  return new AsciiSearchKernel<S>();
+}
+
+#define SEARCH_KERNEL_FUNCTIONS(K) {                                           \
+    { &CreateSearchKernel<K<CaseInsensitive, AnyWord> >,                       \
+      &CreateSearchKernel<K<CaseInsensitive, WholeWord> > },                   \
+    { &CreateSearchKernel<K<CaseSensitive, AnyWord> >,                         \
+      &CreateSearchKernel<K<CaseSensitive, WholeWord> > } }
+
+// Each search kernel instantiated for all case and word modes, indexed by
+// [kernel][kMatchCase][kMatchWholeWord].
+const CreateSearchKernelFunction kSearchKernels[kKernelCount][2][2] = {
+  SEARCH_KERNEL_FUNCTIONS(Bndm32Search),
+  SEARCH_KERNEL_FUNCTIONS(Bndm64Search),
+  SEARCH_KERNEL_FUNCTIONS(BndmLongSearch),
+  SEARCH_KERNEL_FUNCTIONS(BoyerMooreSearch),
+  SEARCH_KERNEL_FUNCTIONS(TwoWaySearch),
+  SEARCH_KERNEL_FUNCTIONS(SimdLiteralSearchSse2),
+  SEARCH_KERNEL_FUNCTIONS(SimdLiteralSearchAvx2),
+  SEARCH_KERNEL_FUNCTIONS(Utf16BndmSearch),
+  SEARCH_KERNEL_FUNCTIONS(Utf16SimdSearchSse2),
+  SEARCH_KERNEL_FUNCTIONS(Utf16SimdSearchAvx2),
+  SEARCH_KERNEL_FUNCTIONS(ApproximateSearchSse2),
+  SEARCH_KERNEL_FUNCTIONS(ApproximateSearchAvx2),
+};
+
+#undef SEARCH_KERNEL_FUNCTIONS
+
+// Returns a new instance of |kernel| specialized for the case and word modes
+// of |options|.
+AsciiSearchBase* CreateSearchKernel(SearchKernel kernel, int options) {
+  bool matchCase = (options & AsciiSearchBase::kMatchCase) != 0;
+  bool matchWholeWord = (options & AsciiSearchBase::kMatchWholeWord) != 0;
+  return kSearchKernels[kernel][matchCase][matchWholeWord]();
+}
+
+// Returns a new instance of |kernel|, searching text folded to lower case
+// ahead of time for case insensitive searches, see |CaseFoldingSearch|.
+AsciiSearchBase* CreateCaseFoldingSearchKernel(
+    SearchKernel kernel,
+    AsciiSearchBase::SearchOptions options,
+    int patternLen) {
+  if (UseCaseFoldingSearch(options, patternLen))
+    return new CaseFoldingSearch(CreateSearchKernel(kernel, AsciiSearchBase::kMatchCase));
+  return CreateSearchKernel(kernel, options);
+}
+
+// Conversions between the 32-bit structures of the original exports and the
+// 64-bit structures used by the search algorithms. The 32-bit lengths and
+// offsets are always large enough, as the texts passed to the original
+// exports are less than 2GB.
+
+// Number of matches (and fragments) converted at a time, using buffers on
+// the stack.
+const int kConversionBatchSize = 64;
+
+AsciiSearchBase::SearchParams64 ToSearchParams64(const AsciiSearchBase::SearchParams& params) {
+  AsciiSearchBase::SearchParams64 result;
+  result.TextStart = params.TextStart;
+  result.TextLength = params.TextLength;
+  result.MatchStart = params.MatchStart;
+  result.MatchLength = params.MatchLength;
+  result.MatchPatternIndex = params.MatchPatternIndex;
+  result.SearchBuffer = params.SearchBuffer;
+  result.ContextStart = params.ContextStart;
+  result.ContextLength = params.ContextLength;
+  result.Cancelled = params.Cancelled;
+  return result;
+}
+
+// |TextStart| and |TextLength| are copied back, as |FindAllFragments| sets
+// them to the fragment being searched when resuming a search.
+void FromSearchParams64(const AsciiSearchBase::SearchParams64& params, AsciiSearchBase::SearchParams* result) {
+  result->TextStart = params.TextStart;
+  result->TextLength = static_cast<int>(params.TextLength);
+  result->MatchStart = params.MatchStart;
+  result->MatchLength = static_cast<int>(params.MatchLength);
+  result->MatchPatternIndex = params.MatchPatternIndex;
+}
+
 }  // namespace
 
 extern "C" {
@@ -238,8 +337,31 @@ enum SearchAlgorithmKind {
   kBoyerMoore = 4,
   kRegex = 5,
   kRe2 = 6,
+  kSimdLiteral = 7,
+  kMultiLiteral = 8,
+  kWildcard = 9,
+  kBndmLong = 10,
+  kTwoWay = 11,
+  kUtf8CaseFolding = 12,
+  kUtf16Bndm = 13,
+  kUtf16SimdLiteral = 14,
+  kApproximate = 15,
 };
 
+// Creates the search algorithm of each entry of a |WildcardSearch|.
+AsciiSearchBase* CreateWildcardEntrySearch(
+    const char* pattern,
+    int patternLen,
+    AsciiSearchBase::SearchOptions options,
+    AsciiSearchBase::SearchCreateResult* searchCreateResult);
+
+// Creates the search algorithm of the atoms of a |RE2Search|.
+AsciiSearchBase* CreateRE2AtomSearch(
+    const char* pattern,
+    int patternLen,
+    AsciiSearchBase::SearchOptions options,
+    AsciiSearchBase::SearchCreateResult* searchCreateResult);
+
 EXPORT AsciiSearchBase* __stdcall AsciiSearchAlgorithm_Create(
     SearchAlgorithmKind kind,
     const char* pattern,
@@ -251,28 +373,62 @@ EXPORT AsciiSearchBase* __stdcall AsciiSearchAlgorithm_Create(
 
   switch(kind) {
     case kBndm32:
-      if (options & AsciiSearchBase::kMatchCase)
-        result = new Bndm32Search<CaseSensitive>();
-      else
-        result = new Bndm32Search<CaseInsensitive>();
+      result = CreateCaseFoldingSearchKernel(kKernelBndm32, options, patternLen);
       break;
     case kBndm64:
-      if (options & AsciiSearchBase::kMatchCase)
-        result = new Bndm64Search<CaseSensitive>();
-      else
-        result = new Bndm64Search<CaseInsensitive>();
+      result = CreateCaseFoldingSearchKernel(kKernelBndm64, options, patternLen);
+      break;
+    case kBndmLong:
+      result = CreateCaseFoldingSearchKernel(kKernelBndmLong, options, patternLen);
       break;
     case kBoyerMoore:
-      result = new BoyerMooreSearch();
+      result = CreateCaseFoldingSearchKernel(kKernelBoyerMoore, options, patternLen);
+      break;
+    case kTwoWay:
+      result = CreateSearchKernel(kKernelTwoWay, options);
+      break;
+    case kApproximate:
+      if (HasCpuFeature(kCpuFeatureAvx2))
+        result = CreateSearchKernel(kKernelApproximateAvx2, options);
+      else
+        result = CreateSearchKernel(kKernelApproximateSse2, options);
+      break;
+    case kSimdLiteral:
+      if (HasCpuFeature(kCpuFeatureAvx2))
+        result = CreateSearchKernel(kKernelSimdLiteralAvx2, options);
+      else
+        result = CreateSearchKernel(kKernelSimdLiteralSse2, options);
+      break;
+    case kUtf8CaseFolding:
+      if (HasCpuFeature(kCpuFeatureAvx2)) {
+        result = new Utf8CaseFoldingSearch(
+          CreateSearchKernel(kKernelSimdLiteralAvx2, AsciiSearchBase::kMatchCase),
+          CreateSearchKernel(kKernelSimdLiteralAvx2, 0));
+      } else {
+        result = new Utf8CaseFoldingSearch(
+          CreateSearchKernel(kKernelSimdLiteralSse2, AsciiSearchBase::kMatchCase),
+          CreateSearchKernel(kKernelSimdLiteralSse2, 0));
+      }
       break;
     case kStrStr:
-      result = new StrStrSearch();
+      if (HasCpuFeature(kCpuFeatureSse42))
+        result = new StrStrSse42Search();
+      else
+        result = new StrStrSearch();
       break;
     case kRegex:
-      result = new RegexSearch();
+      result = new RegexSearch(&CreateRE2AtomSearch);
       break;
     case kRe2:
-      result = new RE2Search();
+      result = new RE2Search(&CreateRE2AtomSearch, RE2Search::kUtf8);
+      break;
+    case kMultiLiteral:
+      result = new MultiLiteralSearch();
+      break;
+    case kWildcard:
+      // Whole word matching applies to each entry, not to the whole match.
+      result = new WildcardSearch(&CreateWildcardEntrySearch, options);
+      options = static_cast<AsciiSearchBase::SearchOptions>(options & ~AsciiSearchBase::kMatchWholeWord);
       break;
   }
 
@@ -290,26 +446,409 @@ EXPORT AsciiSearchBase* __stdcall AsciiSearchAlgorithm_Create(
   return result;
 }
 
+// Creates a search algorithm for UTF-16 text, see search_utf16.h. The
+// returned instance is used with the |AsciiSearchAlgorithm_XXX| functions,
+// with text lengths in characters.
+EXPORT AsciiSearchBase* __stdcall Utf16SearchAlgorithm_Create(
+    SearchAlgorithmKind kind,
+    const wchar_t* pattern,
+    int patternLen,
+    AsciiSearchBase::SearchOptions options,
+    AsciiSearchBase::SearchCreateResult* searchCreateResult) {
+  (*searchCreateResult) = AsciiSearchBase::SearchCreateResult();
+  AsciiSearchBase* result = NULL;
+
+  switch(kind) {
+    case kUtf16Bndm:
+      result = CreateSearchKernel(kKernelUtf16Bndm, options);
+      break;
+    case kUtf16SimdLiteral:
+      if (HasCpuFeature(kCpuFeatureAvx2))
+        result = CreateSearchKernel(kKernelUtf16SimdAvx2, options);
+      else
+        result = CreateSearchKernel(kKernelUtf16SimdSse2, options);
+      break;
+    default:
+      searchCreateResult->SetError(E_INVALIDARG, "Invalid UTF-16 search algorithm");
+      return NULL;
+  }
+
+  if (!result) {
+    searchCreateResult->SetError(E_OUTOFMEMORY, "Out of memory");
+    return result;
+  }
+
+  result->StartSearch(reinterpret_cast<const char*>(pattern), patternLen, options, *searchCreateResult);
+  if (FAILED(searchCreateResult->HResult)) {
+    delete result;
+    return NULL;
+  }
+
+  return result;
+}
+
+AsciiSearchBase* CreateWildcardEntrySearch(
+    const char* pattern,
+    int patternLen,
+    AsciiSearchBase::SearchOptions options,
+    AsciiSearchBase::SearchCreateResult* searchCreateResult) {
+  return AsciiSearchAlgorithm_Create(
+      kSimdLiteral, pattern, patternLen, options, searchCreateResult);
+}
+
+AsciiSearchBase* CreateRE2AtomSearch(
+    const char* pattern,
+    int patternLen,
+    AsciiSearchBase::SearchOptions options,
+    AsciiSearchBase::SearchCreateResult* searchCreateResult) {
+  bool multipleAtoms = std::find(pattern, pattern + patternLen, RE2Search::kAtomSeparator) != pattern + patternLen;
+  return AsciiSearchAlgorithm_Create(
+      multipleAtoms ? kMultiLiteral : kSimdLiteral, pattern, patternLen, options, searchCreateResult);
+}
+
+// The search algorithm selected by |AsciiSearchAlgorithm_CreateBest|, and
+// its throughput on the corpus sample (0 if the sample is empty).
+struct SearchAlgorithmChoice {
+  SearchAlgorithmKind Kind;
+  int SampleLength;
+  double BytesPerSecond;
+};
+
+// Returns the time it takes |search| to find all the matches in |slices|, or
+// a value greater than |timeLimit| if searching takes longer than
+// |timeLimit|.
+std::chrono::steady_clock::duration TimeSearchAlgorithm(
+    AsciiSearchBase* search,
+    const std::vector<std::vector<char>>& slices,
+    std::chrono::steady_clock::duration timeLimit) {
+  const int kMatchCapacity = 256;
+  AsciiSearchBase::SearchMatch64 matches[kMatchCapacity];
+  std::vector<char> searchBuffer(search->GetSearchBufferSize());
+
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = std::chrono::steady_clock::duration::zero();
+  for (const std::vector<char>& slice : slices) {
+    AsciiSearchBase::SearchParams64 searchParams = {};
+    searchParams.TextStart = slice.data();
+    searchParams.TextLength = slice.size();
+    searchParams.SearchBuffer = searchBuffer.data();
+    while (search->FindAll(&searchParams, matches, kMatchCapacity) == kMatchCapacity) {
+    }
+
+    // Candidates slower than the best one so far are abandoned early, so
+    // that the quadratic behavior of some algorithms on some patterns does
+    // not make the selection itself slow.
+    elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed > timeLimit)
+      break;
+  }
+  return elapsed;
+}
+
+// Creates the literal search algorithms suitable for |pattern|, times each
+// of them on a sample of the text files loaded so far (see
+// |GetCorpusSample|), and returns the fastest one. The other ones are
+// deleted. The selected algorithm and its throughput are stored in |choice|.
+// The SIMD literal search is returned if no text file has been loaded yet.
+EXPORT AsciiSearchBase* __stdcall AsciiSearchAlgorithm_CreateBest(
+    const char* pattern,
+    int patternLen,
+    AsciiSearchBase::SearchOptions options,
+    AsciiSearchBase::SearchCreateResult* searchCreateResult,
+    SearchAlgorithmChoice* choice) {
+  std::vector<std::vector<char>> slices;
+  GetCorpusSample(&slices);
+  int sampleLength = 0;
+  for (const std::vector<char>& slice : slices) {
+    sampleLength += static_cast<int>(slice.size());
+  }
+
+  choice->Kind = kSimdLiteral;
+  choice->SampleLength = sampleLength;
+  choice->BytesPerSecond = 0;
+  if (sampleLength == 0 || patternLen <= 0) {
+    return AsciiSearchAlgorithm_Create(
+        kSimdLiteral, pattern, patternLen, options, searchCreateResult);
+  }
+
+  SearchAlgorithmKind candidates[6];
+  int candidateCount = 0;
+  candidates[candidateCount++] = kSimdLiteral;
+  if (patternLen <= 32)
+    candidates[candidateCount++] = kBndm32;
+  else if (patternLen <= 64)
+    candidates[candidateCount++] = kBndm64;
+  else
+    candidates[candidateCount++] = kBndmLong;
+  candidates[candidateCount++] = kBoyerMoore;
+  candidates[candidateCount++] = kTwoWay;
+
+  AsciiSearchBase* best = NULL;
+  auto bestTime = std::chrono::steady_clock::duration::max();
+  for (int i = 0; i < candidateCount; i++) {
+    // A candidate may not support the pattern, the others are still timed.
+    AsciiSearchBase* search = AsciiSearchAlgorithm_Create(
+        candidates[i], pattern, patternLen, options, searchCreateResult);
+    if (!search)
+      continue;
+
+    // The first candidate is run twice, so that all candidates are timed
+    // with the sample in the cache.
+    if (i == 0)
+      TimeSearchAlgorithm(search, slices, bestTime);
+    auto time = TimeSearchAlgorithm(search, slices, bestTime);
+    if (time < bestTime) {
+      delete best;
+      best = search;
+      bestTime = time;
+      choice->Kind = candidates[i];
+    } else {
+      delete search;
+    }
+  }
+
+  // |searchCreateResult| holds the error of the last candidate that could
+  // not be created, if no candidate could.
+  if (best == NULL)
+    return NULL;
+  (*searchCreateResult) = AsciiSearchBase::SearchCreateResult();
+
+  auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(bestTime);
+  if (seconds.count() > 0)
+    choice->BytesPerSecond = sampleLength / seconds.count();
+  return best;
+}
+
+// Returns the |CpuFeatures| used to select the variants of the search
+// algorithms in |AsciiSearchAlgorithm_Create|.
+EXPORT int __stdcall Native_GetCpuFeatures() {
+  return GetCpuFeatures();
+}
+
 EXPORT int __stdcall AsciiSearchAlgorithm_GetSearchBufferSize(AsciiSearchBase* search) {
   return search->GetSearchBufferSize();
 }
 
+EXPORT void __stdcall AsciiSearchAlgorithm_Search64(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchParams64* searchParams) {
+  search->FindNext(searchParams);
+}
+
+// Stores up to |capacity| matches in |matches|, and the number of matches
+// stored in |matchCount|. Whole word matching is applied before matches are
+// stored. See |AsciiSearchBase::FindAll| for resuming a search.
+EXPORT void __stdcall AsciiSearchAlgorithm_FindAll64(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchParams64* searchParams,
+    AsciiSearchBase::SearchMatch64* matches,
+    int capacity,
+    int* matchCount) {
+  *matchCount = search->FindAll(searchParams, matches, capacity);
+}
+
+// Searches many small fragments of text in a single call. See
+// |AsciiSearchBase::FindAllFragments| for resuming a search.
+EXPORT void __stdcall AsciiSearchAlgorithm_FindAllFragments64(
+    AsciiSearchBase* search,
+    const AsciiSearchBase::SearchFragment64* fragments,
+    int fragmentCount,
+    int* fragmentIndex,
+    AsciiSearchBase::SearchParams64* searchParams,
+    AsciiSearchBase::SearchFragmentMatch64* matches,
+    int capacity,
+    int* matchCount) {
+  *matchCount = search->FindAllFragments(
+      fragments, fragmentCount, fragmentIndex, searchParams, matches, capacity);
+}
+
+// Stores the number of matches in |matchCount|, stopping at |maxCount|
+// matches. Use a |maxCount| of 1 to check whether the text contains any
+// match.
+EXPORT void __stdcall AsciiSearchAlgorithm_Count64(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchParams64* searchParams,
+    int maxCount,
+    int* matchCount) {
+  *matchCount = search->Count(searchParams, maxCount);
+}
+
+EXPORT void __stdcall AsciiSearchAlgorithm_CancelSearch64(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchParams64* searchParams) {
+  search->CancelSearch(searchParams);
+}
+
+// The original exports, limited to texts of less than 2GB. They convert
+// their parameters to the 64-bit structures and forward to the exports
+// above.
+
 EXPORT void __stdcall AsciiSearchAlgorithm_Search(
     AsciiSearchBase* search,
     AsciiSearchBase::SearchParams* searchParams) {
-  search->FindNext(searchParams);
+  AsciiSearchBase::SearchParams64 params = ToSearchParams64(*searchParams);
+  AsciiSearchAlgorithm_Search64(search, &params);
+  FromSearchParams64(params, searchParams);
+}
+
+EXPORT void __stdcall AsciiSearchAlgorithm_FindAll(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchParams* searchParams,
+    AsciiSearchBase::SearchMatch* matches,
+    int capacity,
+    int* matchCount) {
+  // The matches are found in batches of |kConversionBatchSize| and
+  // converted, which resumes the search as needed.
+  AsciiSearchBase::SearchMatch64 matches64[kConversionBatchSize];
+  AsciiSearchBase::SearchParams64 params = ToSearchParams64(*searchParams);
+  *matchCount = 0;
+  while (*matchCount < capacity) {
+    int batchCapacity = min(capacity - *matchCount, kConversionBatchSize);
+    int batchCount;
+    AsciiSearchAlgorithm_FindAll64(search, &params, matches64, batchCapacity, &batchCount);
+    AsciiSearchBase::SearchMatch* batchMatches = matches + *matchCount;
+    for (int i = 0; i < batchCount; i++) {
+      batchMatches[i].Offset = static_cast<int>(matches64[i].Offset);
+      batchMatches[i].Length = static_cast<int>(matches64[i].Length);
+    }
+    *matchCount += batchCount;
+    if (batchCount < batchCapacity)
+      break;
+  }
+  FromSearchParams64(params, searchParams);
+}
+
+EXPORT void __stdcall AsciiSearchAlgorithm_FindAllFragments(
+    AsciiSearchBase* search,
+    const AsciiSearchBase::SearchFragment* fragments,
+    int fragmentCount,
+    int* fragmentIndex,
+    AsciiSearchBase::SearchParams* searchParams,
+    AsciiSearchBase::SearchFragmentMatch* matches,
+    int capacity,
+    int* matchCount) {
+  // The fragments from |*fragmentIndex| on are converted and searched
+  // |kConversionBatchSize| at a time, and so are the matches.
+  AsciiSearchBase::SearchFragment64 fragments64[kConversionBatchSize];
+  AsciiSearchBase::SearchFragmentMatch64 matches64[kConversionBatchSize];
+  AsciiSearchBase::SearchParams64 params = ToSearchParams64(*searchParams);
+  *matchCount = 0;
+  while (*matchCount < capacity && *fragmentIndex < fragmentCount) {
+    int firstFragment = *fragmentIndex;
+    int batchFragmentCount = min(fragmentCount - firstFragment, kConversionBatchSize);
+    for (int i = 0; i < batchFragmentCount; i++) {
+      fragments64[i].TextStart = fragments[firstFragment + i].TextStart;
+      fragments64[i].TextLength = fragments[firstFragment + i].TextLength;
+    }
+    int batchFragmentIndex = 0;
+    int batchCapacity = min(capacity - *matchCount, kConversionBatchSize);
+    int batchCount;
+    AsciiSearchAlgorithm_FindAllFragments64(
+        search, fragments64, batchFragmentCount, &batchFragmentIndex, &params,
+        matches64, batchCapacity, &batchCount);
+    AsciiSearchBase::SearchFragmentMatch* batchMatches = matches + *matchCount;
+    for (int i = 0; i < batchCount; i++) {
+      batchMatches[i].FragmentIndex = firstFragment + matches64[i].FragmentIndex;
+      batchMatches[i].Offset = static_cast<int>(matches64[i].Offset);
+      batchMatches[i].Length = static_cast<int>(matches64[i].Length);
+    }
+    *matchCount += batchCount;
+    *fragmentIndex = firstFragment + batchFragmentIndex;
+    // The fragments left are skipped once the search is cancelled.
+    if (params.MatchStart == nullptr && AsciiSearchBase::IsCancelled(&params))
+      *fragmentIndex = fragmentCount;
+  }
+  FromSearchParams64(params, searchParams);
+}
+
+EXPORT void __stdcall AsciiSearchAlgorithm_Count(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchParams* searchParams,
+    int maxCount,
+    int* matchCount) {
+  AsciiSearchBase::SearchParams64 params = ToSearchParams64(*searchParams);
+  AsciiSearchAlgorithm_Count64(search, &params, maxCount, matchCount);
+  FromSearchParams64(params, searchParams);
 }
 
 EXPORT void __stdcall AsciiSearchAlgorithm_CancelSearch(
     AsciiSearchBase* search,
     AsciiSearchBase::SearchParams* searchParams) {
-  search->CancelSearch(searchParams);
+  AsciiSearchBase::SearchParams64 params = ToSearchParams64(*searchParams);
+  AsciiSearchAlgorithm_CancelSearch64(search, &params);
+  FromSearchParams64(params, searchParams);
 }
 
 EXPORT void __stdcall AsciiSearchAlgorithm_Delete(AsciiSearchBase* search) {
   delete search;
 }
 
+// Copies the atoms of a |kRe2| search algorithm (see
+// |RE2Search::GetPrefilterAtoms|) to |buffer| as a NUL terminated string if
+// it fits, and returns their length.
+EXPORT int __stdcall RE2Search_GetPrefilterAtoms(
+    AsciiSearchBase* search,
+    char* buffer,
+    int bufferLength) {
+  const std::string& atoms = static_cast<RE2Search*>(search)->GetPrefilterAtoms();
+  int length = static_cast<int>(atoms.size());
+  if (length < bufferLength)
+    memcpy(buffer, atoms.c_str(), length + 1);
+  return length;
+}
+
+// Copies the statistics of the regular expressions reused across search
+// algorithms to |statistics|, see compiled_pattern_cache.h.
+EXPORT void __stdcall CompiledPatternCache_GetStatistics(
+    CompiledPatternCacheStatistics* statistics) {
+  GetCompiledPatternCacheStatistics(statistics);
+}
+
+// Returns the engine a |kRegex| search algorithm searches its pattern with,
+// see |RegexSearch::GetEngine|.
+EXPORT RegexSearch::Engine __stdcall RegexSearch_GetEngine(AsciiSearchBase* search) {
+  return static_cast<RegexSearch*>(search)->GetEngine();
+}
+
+// Returns a search of a text fed one chunk at a time with |search|, which
+// must outlive the returned instance. See |StreamingSearch|.
+EXPORT StreamingSearch* __stdcall StreamingSearch_Create(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchOptions options,
+    int64_t maxMatchLength) {
+  return new StreamingSearch(search, options, maxMatchLength);
+}
+
+// Searches the next chunk of the text, and stores the number of matches
+// ready to be fetched in |matchCount|.
+EXPORT void __stdcall StreamingSearch_FeedChunk(
+    StreamingSearch* search,
+    const char* chunk,
+    int64_t chunkLength,
+    int* matchCount) {
+  *matchCount = search->FeedChunk(chunk, chunkLength);
+}
+
+// Searches the end of the text, and stores the number of matches ready to
+// be fetched in |matchCount|.
+EXPORT void __stdcall StreamingSearch_Finish(
+    StreamingSearch* search,
+    int* matchCount) {
+  *matchCount = search->Finish();
+}
+
+EXPORT void __stdcall StreamingSearch_FetchMatches(
+    StreamingSearch* search,
+    AsciiSearchBase::SearchMatch64* matches,
+    int capacity,
+    int* matchCount) {
+  *matchCount = search->FetchMatches(matches, capacity);
+}
+
+EXPORT void __stdcall StreamingSearch_Delete(StreamingSearch* search) {
+  delete search;
+}
+
 enum TextKind {
   TextKind_Ascii,
   TextKind_AsciiWithUtf8Bom,
@@ -350,6 +889,28 @@ EXPORT bool __stdcall Ascii_Compare(
   return memcmp(text1, text2, text1Length) == 0;
 }
 
+EXPORT bool __stdcall Ascii_GetLineExtentFromPosition64(
+    const char* text,
+    int64_t textLen,
+    int64_t position,
+    int maxOffset,
+    int64_t* lineStartPosition,
+    int64_t* lineLen) {
+  return GetLineExtentFromPosition(
+      text, textLen, position, maxOffset, lineStartPosition, lineLen);
+}
+
+EXPORT bool __stdcall Utf16_GetLineExtentFromPosition64(
+    const wchar_t* text,
+    int64_t textLen,
+    int64_t position,
+    int maxOffset,
+    int64_t* lineStartPosition,
+    int64_t* lineLen) {
+  return GetLineExtentFromPosition(
+      text, textLen, position, maxOffset, lineStartPosition, lineLen);
+}
+
 EXPORT bool __stdcall Ascii_GetLineExtentFromPosition(
     const char* text,
     int textLen,
@@ -357,23 +918,12 @@ EXPORT bool __stdcall Ascii_GetLineExtentFromPosition(
     int maxOffset,
     int* lineStartPosition,
     int* lineLen) {
-  return GetLineExtentFromPosition(
-      text, textLen, position, maxOffset, lineStartPosition, lineLen);
-}
-
-EXPORT const wchar_t* __stdcall Utf16_Search(
-    const wchar_t *text,
-    size_t textLength,
-    const wchar_t* pattern,
-    size_t patternLength,
-    AsciiSearchBase::SearchOptions options) {
-  const wchar_t* textEnd = text + textLength;
-  const wchar_t* patternEnd = pattern + patternLength;
-  auto result = (options & AsciiSearchBase::kMatchCase)
-    ? std::search(text, textEnd, pattern, patternEnd)
-    : std::search(text, textEnd, pattern, patternEnd, char_equal_icase);
-  if (result == textEnd)
-    return nullptr;
+  int64_t lineStart64 = 0;
+  int64_t lineLen64 = 0;
+  bool result = GetLineExtentFromPosition(
+      text, textLen, position, maxOffset, &lineStart64, &lineLen64);
+  *lineStartPosition = static_cast<int>(lineStart64);
+  *lineLen = static_cast<int>(lineLen64);
   return result;
 }
 
@@ -384,8 +934,13 @@ EXPORT bool __stdcall Utf16_GetLineExtentFromPosition(
     int maxOffset,
     int* lineStartPosition,
     int* lineLen) {
-  return GetLineExtentFromPosition(
-      text, textLen, position, maxOffset, lineStartPosition, lineLen);
+  int64_t lineStart64 = 0;
+  int64_t lineLen64 = 0;
+  bool result = GetLineExtentFromPosition(
+      text, textLen, position, maxOffset, &lineStart64, &lineLen64);
+  *lineStartPosition = static_cast<int>(lineStart64);
+  *lineLen = static_cast<int>(lineLen64);
+  return result;
 }
 
 }  // extern "C"
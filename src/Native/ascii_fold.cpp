@@ -0,0 +1,72 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "ascii_fold.h"
+
+#include <stdint.h>
+
+#include "cpu_features.h"
+#include "simd_vector.h"
+
+namespace {
+
+template <typename V>
+void AsciiFoldToLowerWorker(const uint8_t* src, uint8_t* dst, int len) {
+  // Byte values are compared as signed integers, so non ASCII values
+  // (>= 0x80) are negative and never fall in the ['A', 'Z'] range.
+  const typename V::Type beforeA = V::Set1('A' - 1);
+  const typename V::Type afterZ = V::Set1('Z' + 1);
+  const typename V::Type caseBit = V::Set1(0x20);
+
+  int i = 0;
+  for (; i + V::kSize <= len; i += V::kSize) {
+    typename V::Type block = V::Load(src + i);
+    typename V::Type isUpper = V::And(
+      V::CmpGt(block, beforeA),
+      V::CmpGt(afterZ, block));
+    V::Store(dst + i, V::Or(block, V::And(isUpper, caseBit)));
+  }
+  V::Leave();
+
+  for (; i < len; i++) {
+    uint8_t value = src[i];
+    dst[i] = (value >= 'A' && value <= 'Z') ? (value | 0x20) : value;
+  }
+}
+
+template <typename V>
+int AsciiPrefixLengthWorker(const uint8_t* src, int len) {
+  int i = 0;
+  for (; i + V::kSize <= len; i += V::kSize) {
+    // |MoveMask| collects the high bit of each byte.
+    if (V::MoveMask(V::Load(src + i)) != 0)
+      break;
+  }
+  V::Leave();
+
+  for (; i < len && src[i] < 0x80; i++) {
+  }
+  return i;
+}
+
+}  // namespace
+
+void AsciiFoldToLower(const char* src, char* dst, int len) {
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+  uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+  if (HasCpuFeature(kCpuFeatureAvx2))
+    AsciiFoldToLowerWorker<Avx2Vector>(s, d, len);
+  else
+    AsciiFoldToLowerWorker<Sse2Vector>(s, d, len);
+}
+
+int AsciiPrefixLength(const char* src, int len) {
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+  if (HasCpuFeature(kCpuFeatureAvx2))
+    return AsciiPrefixLengthWorker<Avx2Vector>(s, len);
+  else
+    return AsciiPrefixLengthWorker<Sse2Vector>(s, len);
+}
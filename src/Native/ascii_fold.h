@@ -0,0 +1,14 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+// Copies |len| bytes from |src| to |dst|, converting 'A'-'Z' to 'a'-'z'. All
+// other byte values are copied unchanged. Uses AVX2 or SSE2 range compares to
+// process 32 or 16 bytes at a time.
+void AsciiFoldToLower(const char* src, char* dst, int len);
+
+// Returns the number of bytes at the start of |src| (at most |len|) that are
+// ASCII characters, i.e. less than 0x80. Processes 32 or 16 bytes at a time.
+int AsciiPrefixLength(const char* src, int len);
@@ -0,0 +1,115 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "byte_frequency.h"
+
+namespace {
+
+// Occurrences of each byte value per million bytes of C++ and C# source
+// files.
+const uint32_t kSourceCodeByteFrequencies[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 363, 26996, 0, 0, 19102, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  190601, 606, 2837, 2523, 21, 18, 234, 189, 7972, 7979, 501, 495, 6285, 2215, 10949, 13937,
+  6988, 3389, 2642, 1631, 1493, 1146, 1188, 998, 1109, 1079, 1115, 8002, 1834, 4728, 2312, 150,
+  128, 4583, 2798, 9945, 5715, 6981, 4428, 2253, 1466, 7240, 136, 678, 4208, 3447, 3434, 3385,
+  5354, 218, 3972, 10097, 6663, 1731, 3659, 1855, 287, 138, 90, 891, 322, 891, 0, 5812,
+  0, 36158, 7172, 22129, 21836, 75300, 10645, 11264, 15418, 42008, 889, 2722, 23831, 16774, 38299, 36638,
+  14376, 1078, 43274, 35190, 49728, 20278, 7247, 4058, 6915, 9388, 640, 4569, 211, 4568, 11, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 299, 0, 0, 0, 299,
+  0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 299,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// Below this many bytes, the corpus frequencies are not representative
+// enough, and the static table is used instead.
+const uint64_t kMinCorpusSize = 1024 * 1024;
+
+volatile LONGLONG corpusByteCounts[256];
+volatile LONGLONG corpusSize;
+
+uint64_t GetFrequency(const uint64_t (&frequencies)[256], wchar_t value, bool matchCase) {
+  if (value > 0xFF)
+    return 0;
+  if (matchCase)
+    return frequencies[value];
+  if (value >= 'A' && value <= 'Z')
+    return frequencies[value] + frequencies[value | 0x20];
+  if (value >= 'a' && value <= 'z')
+    return frequencies[value] + frequencies[value & ~0x20];
+  return frequencies[value];
+}
+
+template <typename C>
+void GetRarestOffsets(const C* pattern, int patternLen, bool matchCase,
+                      int* offset1, int* offset2) {
+  uint64_t frequencies[256];
+  GetByteFrequencies(frequencies);
+
+  // Ties are resolved in favor of the last bytes of the pattern, as the
+  // first bytes of identifiers tend to be shared by many words.
+  int rarest = patternLen - 1;
+  for (int i = patternLen - 2; i >= 0; i--) {
+    if (GetFrequency(frequencies, pattern[i], matchCase) <
+        GetFrequency(frequencies, pattern[rarest], matchCase)) {
+      rarest = i;
+    }
+  }
+
+  int second = (rarest == 0) ? patternLen - 1 : 0;
+  for (int i = 0; i < patternLen; i++) {
+    if (i == rarest)
+      continue;
+    if (GetFrequency(frequencies, pattern[i], matchCase) <
+        GetFrequency(frequencies, pattern[second], matchCase)) {
+      second = i;
+    }
+  }
+
+  *offset1 = min(rarest, second);
+  *offset2 = max(rarest, second);
+}
+
+}  // namespace
+
+void AddCorpusByteCounts(const ByteCounts& byteCounts) {
+  LONGLONG total = 0;
+  for (int i = 0; i < 256; i++) {
+    if (byteCounts.counts[i] != 0) {
+      InterlockedExchangeAdd64(&corpusByteCounts[i], byteCounts.counts[i]);
+      total += byteCounts.counts[i];
+    }
+  }
+  InterlockedExchangeAdd64(&corpusSize, total);
+}
+
+void GetByteFrequencies(uint64_t (&frequencies)[256]) {
+  if ((uint64_t)corpusSize < kMinCorpusSize) {
+    for (int i = 0; i < 256; i++) {
+      frequencies[i] = kSourceCodeByteFrequencies[i];
+    }
+    return;
+  }
+
+  for (int i = 0; i < 256; i++) {
+    frequencies[i] = corpusByteCounts[i];
+  }
+}
+
+void GetRarestByteOffsets(const uint8_t* pattern, int patternLen, bool matchCase,
+                          int* offset1, int* offset2) {
+  GetRarestOffsets(pattern, patternLen, matchCase, offset1, offset2);
+}
+
+void GetRarestCharOffsets(const wchar_t* pattern, int patternLen, bool matchCase,
+                          int* offset1, int* offset2) {
+  GetRarestOffsets(pattern, patternLen, matchCase, offset1, offset2);
+}
@@ -0,0 +1,36 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Number of occurrences of each byte value in a text.
+struct ByteCounts {
+  ByteCounts() {
+    memset(counts, 0, sizeof(counts));
+  }
+  uint32_t counts[256];
+};
+
+// Adds the byte counts of a text file to the frequencies of the corpus (i.e.
+// all the text files loaded so far). Thread safe.
+void AddCorpusByteCounts(const ByteCounts& byteCounts);
+
+// Fills |frequencies| with the relative frequency of each byte value. The
+// corpus frequencies are used once enough text has been loaded, a static
+// table computed from C++ and C# source files is used until then.
+void GetByteFrequencies(uint64_t (&frequencies)[256]);
+
+// Returns the offsets of the two least frequent bytes of |pattern| (the same
+// offset twice if |patternLen| is 1). When |matchCase| is false, the
+// frequencies of both cases of a letter are added together.
+void GetRarestByteOffsets(const uint8_t* pattern, int patternLen, bool matchCase,
+                          int* offset1, int* offset2);
+
+// Same as |GetRarestByteOffsets| for a UTF-16 pattern. Characters beyond
+// 0xFF are considered rarer than any byte value.
+void GetRarestCharOffsets(const wchar_t* pattern, int patternLen, bool matchCase,
+                          int* offset1, int* offset2);
@@ -0,0 +1,102 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "compiled_pattern_cache.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+
+namespace {
+
+// Compiled patterns keep the memory of their engine (e.g. the DFA states of
+// RE2, one set per clone kept, see |kMaxIdleClones| in search_re2.cpp), so
+// only the patterns of the last few queries are kept: enough for
+// search-as-you-type and re-running a query with other file filters.
+const int kCapacity = 16;
+
+struct CacheEntry {
+  CompiledPatternEngine engine;
+  int options;
+  std::string pattern;
+  std::shared_ptr<CompiledPattern> compiled;
+};
+
+std::mutex cacheLock;
+// Most recently used first. The cache is small enough to be searched
+// linearly.
+std::list<CacheEntry> cacheEntries;
+CompiledPatternCacheStatistics cacheStatistics;
+
+std::list<CacheEntry>::iterator FindEntry(
+    CompiledPatternEngine engine,
+    const char* pattern,
+    int patternLen,
+    int options) {
+  for (auto it = cacheEntries.begin(); it != cacheEntries.end(); ++it) {
+    if (it->engine == engine &&
+        it->options == options &&
+        it->pattern.compare(0, std::string::npos, pattern, patternLen) == 0) {
+      return it;
+    }
+  }
+  return cacheEntries.end();
+}
+
+}  // namespace
+
+std::shared_ptr<CompiledPattern> FindCompiledPattern(
+    CompiledPatternEngine engine,
+    const char* pattern,
+    int patternLen,
+    int options) {
+  std::lock_guard<std::mutex> lock(cacheLock);
+  auto it = FindEntry(engine, pattern, patternLen, options);
+  if (it == cacheEntries.end()) {
+    cacheStatistics.Misses++;
+    return nullptr;
+  }
+
+  cacheStatistics.Hits++;
+  cacheEntries.splice(cacheEntries.begin(), cacheEntries, it);
+  return it->compiled;
+}
+
+void AddCompiledPattern(
+    CompiledPatternEngine engine,
+    const char* pattern,
+    int patternLen,
+    int options,
+    const std::shared_ptr<CompiledPattern>& compiled) {
+  std::lock_guard<std::mutex> lock(cacheLock);
+  // Another thread may have compiled the same pattern in the meantime.
+  auto it = FindEntry(engine, pattern, patternLen, options);
+  if (it != cacheEntries.end()) {
+    it->compiled = compiled;
+    cacheEntries.splice(cacheEntries.begin(), cacheEntries, it);
+    return;
+  }
+
+  CacheEntry entry;
+  entry.engine = engine;
+  entry.options = options;
+  entry.pattern.assign(pattern, patternLen);
+  entry.compiled = compiled;
+  cacheEntries.push_front(entry);
+  if (static_cast<int>(cacheEntries.size()) > kCapacity) {
+    // The searches using the evicted pattern keep it alive until they are
+    // deleted.
+    cacheEntries.pop_back();
+    cacheStatistics.Evictions++;
+  }
+}
+
+void GetCompiledPatternCacheStatistics(CompiledPatternCacheStatistics* statistics) {
+  std::lock_guard<std::mutex> lock(cacheLock);
+  *statistics = cacheStatistics;
+  statistics->EntryCount = static_cast<int>(cacheEntries.size());
+  statistics->Capacity = kCapacity;
+}
@@ -0,0 +1,53 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+
+// A regular expression compiled by a search algorithm, shared by the search
+// algorithms created later for the same pattern and options. Must be thread
+// safe once compiled, since these search algorithms may run concurrently.
+class CompiledPattern {
+ public:
+  virtual ~CompiledPattern() {}
+};
+
+enum CompiledPatternEngine {
+  kEngineStdRegex,
+  kEngineRE2,
+  // RE2 matching bytes instead of UTF-8 characters, see |RE2Search::kLatin1|.
+  kEngineRE2Latin1,
+};
+
+// Returns the pattern compiled by |engine| for |pattern| and |options|, or
+// null if it is not in the cache. Thread safe.
+std::shared_ptr<CompiledPattern> FindCompiledPattern(
+    CompiledPatternEngine engine,
+    const char* pattern,
+    int patternLen,
+    int options);
+
+// Adds a pattern compiled by |engine| to the cache. The least recently used
+// pattern is evicted once the cache is full. Thread safe.
+void AddCompiledPattern(
+    CompiledPatternEngine engine,
+    const char* pattern,
+    int patternLen,
+    int options,
+    const std::shared_ptr<CompiledPattern>& compiled);
+
+struct CompiledPatternCacheStatistics {
+  int64_t Hits;
+  int64_t Misses;
+  int64_t Evictions;
+  int EntryCount;
+  int Capacity;
+};
+
+// Stores the number of lookups found in the cache (|Hits|) or not
+// (|Misses|) since the process started. Thread safe.
+void GetCompiledPatternCacheStatistics(CompiledPatternCacheStatistics* statistics);
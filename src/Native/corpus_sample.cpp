@@ -0,0 +1,47 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "corpus_sample.h"
+
+#include <mutex>
+
+namespace {
+
+// The sample is made of up to 64 slices of 4KB, i.e. 256KB, which is enough
+// to tell search algorithms apart and small enough to be searched in a
+// fraction of a millisecond by each of them.
+const int kSliceCount = 64;
+const int kSliceSize = 4 * 1024;
+
+std::mutex sampleLock;
+std::vector<char> sampleSlices[kSliceCount];
+int nextSlice;
+
+}  // namespace
+
+void AddCorpusSample(const char* text, int textLen) {
+  if (textLen <= 0)
+    return;
+
+  // The middle of a file is more representative than its beginning, which
+  // is often a copyright header.
+  int sliceLen = min(textLen, kSliceSize);
+  const char* slice = text + (textLen - sliceLen) / 2;
+
+  std::lock_guard<std::mutex> lock(sampleLock);
+  std::vector<char>& entry = sampleSlices[nextSlice];
+  entry.assign(slice, slice + sliceLen);
+  nextSlice = (nextSlice + 1) % kSliceCount;
+}
+
+void GetCorpusSample(std::vector<std::vector<char>>* slices) {
+  slices->clear();
+  std::lock_guard<std::mutex> lock(sampleLock);
+  for (int i = 0; i < kSliceCount; i++) {
+    if (!sampleSlices[i].empty())
+      slices->push_back(sampleSlices[i]);
+  }
+}
@@ -0,0 +1,18 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <vector>
+
+// Adds a slice of a text file to the sample of the corpus (i.e. the text
+// files loaded so far) used to time the search algorithms (see
+// |AsciiSearchAlgorithm_CreateBest|). The oldest slices are replaced once the
+// sample is full, so that the sample follows the files loaded last. Thread
+// safe.
+void AddCorpusSample(const char* text, int textLen);
+
+// Stores the slices of the corpus sample in |slices|, which is empty if no
+// text file has been loaded yet. Thread safe.
+void GetCorpusSample(std::vector<std::vector<char>>* slices);
@@ -0,0 +1,56 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include <intrin.h>
+
+#include "cpu_features.h"
+
+namespace {
+
+// See "Intel 64 and IA-32 Architectures Software Developer's Manual",
+// "CPUID - CPU Identification".
+const int kCpuidEdxSse2 = 1 << 26;
+const int kCpuidEcxSse42 = 1 << 20;
+const int kCpuidEcxOsxsave = 1 << 27;
+const int kCpuidEcxAvx = 1 << 28;
+const int kCpuidExtEbxAvx2 = 1 << 5;
+
+// XCR0 bits for the XMM and YMM register states.
+const unsigned long long kXcr0SseAvxState = 0x6;
+
+CpuFeatures DetectCpuFeatures() {
+  int info[4] = { 0 };
+  __cpuid(info, 0);
+  int maxLeaf = info[0];
+  if (maxLeaf < 1)
+    return kCpuFeatureNone;
+
+  int result = kCpuFeatureNone;
+  __cpuid(info, 1);
+  int ecx = info[2];
+  int edx = info[3];
+  if (edx & kCpuidEdxSse2)
+    result |= kCpuFeatureSse2;
+  if (ecx & kCpuidEcxSse42)
+    result |= kCpuFeatureSse42;
+
+  // AVX2 requires the OS to save the YMM registers on context switches.
+  bool osAvx = (ecx & kCpuidEcxOsxsave) && (ecx & kCpuidEcxAvx) &&
+    ((_xgetbv(0) & kXcr0SseAvxState) == kXcr0SseAvxState);
+  if (osAvx && maxLeaf >= 7) {
+    __cpuid(info, 7);
+    if (info[1] & kCpuidExtEbxAvx2)
+      result |= kCpuFeatureAvx2;
+  }
+  return static_cast<CpuFeatures>(result);
+}
+
+}  // namespace
+
+CpuFeatures GetCpuFeatures() {
+  static CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
@@ -0,0 +1,22 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+// Instruction set extensions used by the search algorithms, as reported by
+// "cpuid" on the current machine.
+enum CpuFeatures {
+  kCpuFeatureNone = 0x0000,
+  kCpuFeatureSse2 = 0x0001,
+  kCpuFeatureSse42 = 0x0002,
+  kCpuFeatureAvx2 = 0x0004,
+};
+
+// Returns the set of features supported by both the CPU and the OS. The
+// value is computed on the first call and cached afterwards.
+CpuFeatures GetCpuFeatures();
+
+inline bool HasCpuFeature(CpuFeatures feature) {
+  return (GetCpuFeatures() & feature) != 0;
+}
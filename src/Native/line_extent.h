@@ -0,0 +1,55 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+
+// Computes the extent of the line containing |position|, looking at most
+// |maxOffset| characters before and after |position|. The extent includes
+// the terminating new line character, if any.
+template<class CharType>
+bool GetLineExtentFromPosition(
+    const CharType* text,
+    int64_t textLen,
+    int64_t position,
+    int maxOffset,
+    int64_t* lineStartPosition,
+    int64_t* lineLen) {
+  const CharType nl = '\n';
+  const CharType* low = max(text, text + position - maxOffset);
+  const CharType* high = min(text + textLen, text + position + maxOffset);
+  const CharType* current = text + position;
+
+  // Search backward up to "low" included
+  const CharType* start = current;
+  if (start > low) {
+    start--;
+    for (; start >= low; start--) {
+      if (*start == nl) {
+        break;
+      }
+    }
+    start++;
+  }
+
+  // Search forward up to "high" excluded
+  const CharType* end = current;
+  for (; end < high; end++) {
+    if (*end == nl) {
+      end++;
+      break;
+    }
+  }
+
+  assert(low <= start);
+  assert(start <= high);
+  assert(low <= end);
+  assert(end <= high);
+
+  *lineStartPosition = start - text;
+  *lineLen = end - start;
+  return true;
+}
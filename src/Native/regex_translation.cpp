@@ -0,0 +1,361 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "regex_translation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+namespace {
+
+// The characters matched by "\s" in std::regex, which RE2 matches without
+// "\v".
+const char kSpaceCharacters[] = "\\t\\n\\v\\f\\r ";
+
+bool IsDigit(char ch) {
+  return ch >= '0' && ch <= '9';
+}
+
+bool IsAlphaNumeric(char ch) {
+  return IsDigit(ch) || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+int HexDigitValue(char ch) {
+  if (ch >= '0' && ch <= '9')
+    return ch - '0';
+  if (ch >= 'a' && ch <= 'f')
+    return ch - 'a' + 10;
+  if (ch >= 'A' && ch <= 'F')
+    return ch - 'A' + 10;
+  return -1;
+}
+
+// Appends |ch| as a hexadecimal escape, which means the same character in
+// both syntaxes whatever the character.
+void AppendHexEscape(unsigned char ch, std::string* result) {
+  char buffer[8];
+  sprintf_s(buffer, "\\x%02X", ch);
+  result->append(buffer);
+}
+
+// Translates the escape sequence at |pattern[*index]| ('\\'), inside a
+// character class if |inClass| is true, and moves |*index| past it.
+bool TranslateEscape(
+    const char* pattern,
+    int patternLen,
+    bool caseSensitive,
+    bool inClass,
+    int* index,
+    std::string* result) {
+  if (*index + 1 >= patternLen)
+    return false;
+  const char ch = pattern[*index + 1];
+  *index += 2;
+  switch (ch) {
+    case 'd': case 'D':
+    case 'w': case 'W':
+    case 't': case 'n': case 'r': case 'f': case 'v':
+      result->push_back('\\');
+      result->push_back(ch);
+      return true;
+    case 'b': case 'B':
+      // "[\b]" is a backspace in ECMAScript.
+      if (inClass)
+        return false;
+      result->push_back('\\');
+      result->push_back(ch);
+      return true;
+    case 's':
+      if (inClass) {
+        result->append(kSpaceCharacters);
+      } else {
+        result->append("[");
+        result->append(kSpaceCharacters);
+        result->append("]");
+      }
+      return true;
+    case 'S':
+      if (inClass)
+        return false;
+      result->append("[^");
+      result->append(kSpaceCharacters);
+      result->append("]");
+      return true;
+    case 'x': {
+      if (*index + 2 > patternLen)
+        return false;
+      const int high = HexDigitValue(pattern[*index]);
+      const int low = HexDigitValue(pattern[*index + 1]);
+      if (high < 0 || low < 0)
+        return false;
+      const int value = high * 16 + low;
+      // RE2 folds the case of Latin-1 letters, std::regex only that of ASCII
+      // letters.
+      if (value >= 0x80 && !caseSensitive)
+        return false;
+      AppendHexEscape(static_cast<unsigned char>(value), result);
+      *index += 2;
+      return true;
+    }
+    default:
+      // Backreferences, "\0", "\c", "\u", etc.
+      if (IsAlphaNumeric(ch) || static_cast<unsigned char>(ch) >= 0x80)
+        return false;
+      // Escaped punctuation stands for itself.
+      AppendHexEscape(static_cast<unsigned char>(ch), result);
+      return true;
+  }
+}
+
+// Translates the character class at |pattern[*index]| ('[') and moves
+// |*index| past it.
+bool TranslateCharacterClass(
+    const char* pattern,
+    int patternLen,
+    bool caseSensitive,
+    int* index,
+    std::string* result) {
+  static const char* const kClassNames[] = {
+    "alnum", "alpha", "blank", "cntrl", "digit", "graph",
+    "lower", "print", "punct", "space", "upper", "xdigit",
+  };
+
+  int i = *index + 1;
+  result->push_back('[');
+  if (i < patternLen && pattern[i] == '^') {
+    result->push_back('^');
+    i++;
+  }
+  // "[]" matches nothing and "[^]" anything in ECMAScript, whereas RE2 reads
+  // the ']' as a literal.
+  if (i < patternLen && pattern[i] == ']')
+    return false;
+
+  while (i < patternLen && pattern[i] != ']') {
+    const char ch = pattern[i];
+    if (ch == '\\') {
+      if (!TranslateEscape(pattern, patternLen, caseSensitive, true, &i, result))
+        return false;
+    } else if (ch == '[') {
+      if (i + 1 < patternLen && (pattern[i + 1] == '=' || pattern[i + 1] == '.'))
+        return false;
+      if (i + 1 < patternLen && pattern[i + 1] == ':') {
+        const char* nameStart = pattern + i + 2;
+        const char* nameEnd = nameStart;
+        while (nameEnd < pattern + patternLen && *nameEnd != ':')
+          nameEnd++;
+        if (nameEnd + 1 >= pattern + patternLen || nameEnd[1] != ']')
+          return false;
+        bool found = false;
+        for (const char* name : kClassNames) {
+          if (strlen(name) == static_cast<size_t>(nameEnd - nameStart) &&
+              memcmp(name, nameStart, nameEnd - nameStart) == 0) {
+            found = true;
+          }
+        }
+        if (!found)
+          return false;
+        result->append(pattern + i, nameEnd + 2);
+        i = static_cast<int>(nameEnd + 2 - pattern);
+      } else {
+        AppendHexEscape('[', result);
+        i++;
+      }
+    } else if (static_cast<unsigned char>(ch) >= 0x80) {
+      return false;
+    } else if (ch == '-' || (ch >= 0x20 && ch < 0x7F)) {
+      result->push_back(ch);
+      i++;
+    } else {
+      AppendHexEscape(static_cast<unsigned char>(ch), result);
+      i++;
+    }
+  }
+  if (i >= patternLen)
+    return false;
+
+  result->push_back(']');
+  *index = i + 1;
+  return true;
+}
+
+// Parses the bounded repeat at |pattern[*index]| ('{'), e.g. "{2}", "{2,}"
+// or "{2,5}", and moves |*index| past it. |*max| is -1 if there is no upper
+// bound. Returns false if the brace does not start a valid bounded repeat:
+// RE2 reads it as a literal, std::regex as an error.
+bool ParseBoundedRepeat(const char* pattern, int patternLen, int* index, int* min, int* max) {
+  int i = *index + 1;
+  const int minStart = i;
+  while (i < patternLen && IsDigit(pattern[i]))
+    i++;
+  if (i == minStart)
+    return false;
+  *min = atoi(pattern + minStart);
+  *max = *min;
+  if (i < patternLen && pattern[i] == ',') {
+    i++;
+    const int maxStart = i;
+    while (i < patternLen && IsDigit(pattern[i]))
+      i++;
+    *max = (i == maxStart ? -1 : atoi(pattern + maxStart));
+  }
+  if (i >= patternLen || pattern[i] != '}')
+    return false;
+  *index = i + 1;
+  return true;
+}
+
+// Whether the terms of an alternation (the whole pattern or a group) can
+// match the empty text. When an iteration of a repeated group matches the
+// empty text, std::regex rejects it and backtracks into other choices (e.g.
+// the "b" of "(a?|b)*"), whereas RE2 stops repeating. Repeats of terms that
+// can match the empty text are left to std::regex.
+struct Alternation {
+  Alternation() : alternativeEmpty(false), prefixEmpty(true), lastEmpty(true) {
+  }
+
+  // Adds a term to the current alternative.
+  void AddTerm(bool empty) {
+    prefixEmpty = prefixEmpty && lastEmpty;
+    lastEmpty = empty;
+  }
+  // Starts the next alternative.
+  void AddAlternative() {
+    alternativeEmpty = alternativeEmpty || CanMatchEmpty();
+    prefixEmpty = true;
+    lastEmpty = true;
+  }
+  bool CanMatchEmpty() const {
+    return alternativeEmpty || (prefixEmpty && lastEmpty);
+  }
+
+  // An alternative before the current one can match the empty text.
+  bool alternativeEmpty;
+  // The terms of the current alternative before the last one can all match
+  // the empty text.
+  bool prefixEmpty;
+  // The last term of the current alternative can match the empty text.
+  bool lastEmpty;
+};
+
+}  // namespace
+
+bool TranslateRegexToRE2(
+    const char* pattern,
+    int patternLen,
+    bool caseSensitive,
+    std::string* re2Pattern) {
+  std::string result;
+  // The innermost group last.
+  std::vector<Alternation> groups(1);
+  int i = 0;
+  while (i < patternLen) {
+    const char ch = pattern[i];
+    switch (ch) {
+      case '\\': {
+        const bool assertion = (i + 1 < patternLen && (pattern[i + 1] == 'b' || pattern[i + 1] == 'B'));
+        if (!TranslateEscape(pattern, patternLen, caseSensitive, false, &i, &result))
+          return false;
+        groups.back().AddTerm(assertion);
+        break;
+      }
+      case '[':
+        if (!TranslateCharacterClass(pattern, patternLen, caseSensitive, &i, &result))
+          return false;
+        groups.back().AddTerm(false);
+        break;
+      case '.':
+        // std::regex does not match line terminators with ".", RE2 only
+        // excludes '\n'.
+        result.append("[^\\n\\r]");
+        groups.back().AddTerm(false);
+        i++;
+        break;
+      case '^':
+      case '$':
+        result.push_back(ch);
+        groups.back().AddTerm(true);
+        i++;
+        break;
+      case '(':
+        if (i + 1 < patternLen && pattern[i + 1] == '?') {
+          // Lookahead assertions, "(?=" and "(?!", have no RE2 equivalent.
+          if (i + 2 >= patternLen || pattern[i + 2] != ':')
+            return false;
+          result.append("(?:");
+          i += 3;
+        } else {
+          result.push_back(ch);
+          i++;
+        }
+        groups.push_back(Alternation());
+        break;
+      case ')': {
+        if (groups.size() == 1)
+          return false;
+        const bool empty = groups.back().CanMatchEmpty();
+        groups.pop_back();
+        groups.back().AddTerm(empty);
+        result.push_back(ch);
+        i++;
+        break;
+      }
+      case '|':
+        groups.back().AddAlternative();
+        result.push_back(ch);
+        i++;
+        break;
+      case '*':
+      case '+':
+      case '?':
+      case '{': {
+        const int start = i;
+        int min = (ch == '+' ? 1 : 0);
+        int max = (ch == '?' ? 1 : -1);
+        if (ch == '{') {
+          if (!ParseBoundedRepeat(pattern, patternLen, &i, &min, &max))
+            return false;
+        } else {
+          i++;
+        }
+        // Lazy repeat.
+        if (i < patternLen && pattern[i] == '?')
+          i++;
+        Alternation& group = groups.back();
+        if (group.lastEmpty && max != 0 && max != 1)
+          return false;
+        if (min == 0)
+          group.lastEmpty = true;
+        result.append(pattern + start, pattern + i);
+        break;
+      }
+      default:
+        if (static_cast<unsigned char>(ch) >= 0x80)
+          return false;
+        if (ch >= 0x20 && ch < 0x7F) {
+          result.push_back(ch);
+        } else {
+          AppendHexEscape(static_cast<unsigned char>(ch), &result);
+        }
+        groups.back().AddTerm(false);
+        i++;
+        break;
+    }
+  }
+  if (groups.size() != 1)
+    return false;
+  // After an empty match, std::regex looks for a non empty match at the same
+  // position before moving on (e.g. "b" for "|b" in "b"), and reports empty
+  // matches with a length of 0. |RE2Search| does neither.
+  if (groups.back().CanMatchEmpty())
+    return false;
+
+  re2Pattern->swap(result);
+  return true;
+}
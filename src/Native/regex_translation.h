@@ -0,0 +1,23 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <string>
+
+// Translates |pattern|, an ECMAScript regular expression as parsed by
+// std::regex, to an RE2 pattern compiled with the Latin-1 encoding (i.e.
+// matching bytes), and stores it in |re2Pattern|. Both patterns find the
+// same matches.
+//
+// Returns false if the pattern has no RE2 equivalent (backreferences,
+// lookahead assertions), if RE2 would interpret it differently (e.g. "[]"
+// or non ASCII characters, which RE2 folds beyond ASCII), if it can match
+// the empty text (e.g. "a*"), or if it is not a valid ECMAScript pattern,
+// so that std::regex reports the error.
+bool TranslateRegexToRE2(
+    const char* pattern,
+    int patternLen,
+    bool caseSensitive,
+    std::string* re2Pattern);
@@ -0,0 +1,349 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <intrin.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "search_base.h"
+#include "search_simd_literal.h"
+#include "simd_vector.h"
+
+// Approximate search: finds the substrings of the text whose edit distance
+// to the pattern (number of inserted, deleted or substituted characters) is
+// at most the number of errors of the |kMaxErrorsMask| option, e.g.
+// "RenderFrameHots" for "RenderFrameHost" with 2 errors.
+//
+// The end of the matches is found with Myers' bit-parallel algorithm, which
+// computes a column of the edit distance matrix per text character with a
+// few operations on 64-bit words, hence the pattern length limit. The match
+// ends at the position of least distance among the first one reaching the
+// number of errors and the following ones up to that number, and its start
+// is the one of the best alignment of the pattern ending there. Matches
+// don't overlap.
+//
+// Myers' algorithm processes one character at a time, so the text is
+// filtered first: if the pattern is split in |k + 1| pieces, a match with
+// |k| errors contains at least one of the pieces unchanged. The pieces are
+// searched with packed compares of their first and last characters (as in
+// |SimdLiteralSearch|), and Myers' algorithm only runs around them.
+//
+// See G. Myers, "A fast bit-vector algorithm for approximate string matching
+// based on dynamic programming", J. ACM 46(3), 1999.
+template<typename T, typename W = AnyWord, typename V = Sse2Vector>
+class ApproximateSearch : public AsciiSearchBaseTemplate<T, W> {
+ public:
+  enum { kMaxPatternLength = 64 };
+
+  ApproximateSearch()
+      : pattern_(NULL),
+        patternLen_(0),
+        maxErrors_(0),
+        pieceCount_(0) {
+    memset(peq_, 0, sizeof(peq_));
+  }
+
+  void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE {
+    maxErrors_ = (options & kMaxErrorsMask) >> kMaxErrorsShift;
+    if (patternLen > kMaxPatternLength) {
+      result.SetError(E_INVALIDARG, "Pattern is too long for approximate search");
+      return;
+    }
+    if (maxErrors_ >= patternLen) {
+      result.SetError(E_INVALIDARG, "Pattern is too short for the number of errors");
+      return;
+    }
+
+    pattern_ = pattern;
+    patternLen_ = patternLen;
+    const uint8_t* pat = (const uint8_t*)pattern;
+    for (int ch = 0; ch < kAlphabetLen; ch++) {
+      uint8_t value = static_cast<uint8_t>(ch);
+      for (int i = 0; i < patternLen; i++) {
+        if (Traits::FetchByte(&value, 0) == Traits::FetchByte(pat, i))
+          peq_[ch] |= uint64_t(1) << i;
+      }
+    }
+
+    // Pieces of a single character would produce too many candidates: the
+    // whole text is then searched with Myers' algorithm.
+    pieceCount_ = 0;
+    int pieceCount = maxErrors_ + 1;
+    if (patternLen / pieceCount >= kMinPieceLength) {
+      pieceCount_ = pieceCount;
+      for (int i = 0; i < pieceCount; i++) {
+        pieceOffset_[i] = patternLen * i / pieceCount;
+        pieceLen_[i] = patternLen * (i + 1) / pieceCount - pieceOffset_[i];
+      }
+    }
+  }
+
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
+    const char* text = searchParams->TextStart;
+    const char* textEnd = searchParams->TextStart + searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = searchParams->MatchStart + searchParams->MatchLength;
+    }
+
+    while (true) {
+      int matchLength;
+      const char* match = approximate_algo(text, textEnd - text, &matchLength);
+      searchParams->MatchStart = match;
+      if (match == nullptr)
+        break;
+      searchParams->MatchLength = matchLength;
+      if (WordTraits::IsWordMatch(searchParams->TextStart, textEnd, match, matchLength))
+        break;
+      // Skip the match, as |FindNextWholeWord| would.
+      text = match + matchLength;
+    }
+  }
+
+ private:
+  enum { kMinPieceLength = 2 };
+  enum { kMaxPieceCount = (kMaxErrorsMask >> kMaxErrorsShift) + 1 };
+
+  // The state of Myers' algorithm: the vertical positive and negative deltas
+  // of the current column, and the edit distance of the pattern to the best
+  // substring ending at the current position.
+  struct MyersState {
+    uint64_t pv;
+    uint64_t mv;
+    int score;
+  };
+
+  static uint8_t ToUpper(uint8_t value) {
+    return (value >= 'a' && value <= 'z') ? (value & ~0x20) : value;
+  }
+
+  void ResetState(MyersState& state) const {
+    state.pv = ~uint64_t(0);
+    state.mv = 0;
+    state.score = patternLen_;
+  }
+
+  // Computes the next column of the edit distance matrix, see Myers' paper.
+  // The first row is 0, as matches can start anywhere in the text.
+  static void Step(uint64_t eq, uint64_t highBit, uint64_t& pv, uint64_t& mv, int& score) {
+    uint64_t xv = eq | mv;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    score += ((ph & highBit) != 0) - ((mh & highBit) != 0);
+    ph <<= 1;
+    mh <<= 1;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+  }
+
+  // Advances |state| over the characters of [from, to), and returns the
+  // position of the first character ending a match, or -1.
+  int64_t Scan(const uint8_t* tgt, int64_t from, int64_t to, MyersState& state) const {
+    const uint64_t highBit = uint64_t(1) << (patternLen_ - 1);
+    const int maxErrors = maxErrors_;
+    uint64_t pv = state.pv;
+    uint64_t mv = state.mv;
+    int score = state.score;
+    int64_t i = from;
+    for (; i < to; i++) {
+      Step(peq_[tgt[i]], highBit, pv, mv, score);
+      if (score <= maxErrors)
+        break;
+    }
+    state.pv = pv;
+    state.mv = mv;
+    state.score = score;
+    return i < to ? i : -1;
+  }
+
+  // Returns the start of the match ending with the character at |last|.
+  const char* ReportMatch(const char* text, int64_t textLen, int64_t last, MyersState& state, int* matchLength) const {
+    const uint8_t* tgt = (const uint8_t*)text;
+    const uint64_t highBit = uint64_t(1) << (patternLen_ - 1);
+
+    // Extend the match to the end of least distance within the next
+    // |maxErrors_| characters, e.g. to match "foo" instead of "fo" with 1
+    // error. Among ends at the same distance, the last one is preferred,
+    // e.g. to match "ptx" instead of "pt" for "ptr".
+    int64_t end = last + 1;
+    int best = state.score;
+    const int64_t limit = min(textLen, last + 1 + maxErrors_);
+    for (int64_t i = last + 1; i < limit; i++) {
+      Step(peq_[tgt[i]], highBit, state.pv, state.mv, state.score);
+      if (state.score > maxErrors_)
+        break;
+      if (state.score <= best) {
+        best = state.score;
+        end = i + 1;
+      }
+    }
+
+    int64_t start = FindMatchStart(tgt, end);
+    *matchLength = static_cast<int>(end - start);
+    return text + start;
+  }
+
+  // Returns the first match in |text|, and its length in |matchLength|.
+  const char* approximate_algo(const char* text, int64_t textLen, int* matchLength) const {
+    if (patternLen_ <= 0)
+      return NULL;
+
+    MyersState state;
+    ResetState(state);
+    if (pieceCount_ == 0) {
+      int64_t last = Scan((const uint8_t*)text, 0, textLen, state);
+      if (last < 0)
+        return NULL;
+      return ReportMatch(text, textLen, last, state, matchLength);
+    }
+
+    return filter_algo(text, textLen, state, matchLength);
+  }
+
+  // Returns true if one of the pieces of the pattern starts at |position|.
+  bool IsPieceAt(const uint8_t* tgt, int64_t textLen, int64_t position) const {
+    const uint8_t* pat = (const uint8_t*)pattern_;
+    for (int p = 0; p < pieceCount_; p++) {
+      if (position + pieceLen_[p] > textLen)
+        continue;
+      int j = 0;
+      while (j < pieceLen_[p] &&
+             Traits::FetchByte(tgt, position + j) == Traits::FetchByte(pat, pieceOffset_[p] + j)) {
+        j++;
+      }
+      if (j == pieceLen_[p])
+        return true;
+    }
+    return false;
+  }
+
+  // Runs Myers' algorithm around the piece found at |position|, continuing
+  // from the text already scanned up to |scanned| if possible. Matches
+  // containing the piece end at most |patternLen_ + maxErrors_| characters
+  // after it, and start at most as many characters before it. Since pieces
+  // are processed in order, no match ends before |position|.
+  int64_t ScanCandidate(const uint8_t* tgt, int64_t textLen, int64_t position, int64_t& scanned, MyersState& state) const {
+    int64_t windowStart = max(int64_t(0), position - patternLen_ - maxErrors_);
+    int64_t windowEnd = min(textLen, position + patternLen_ + maxErrors_);
+    if (scanned < windowStart) {
+      ResetState(state);
+      scanned = windowStart;
+    }
+    if (scanned >= windowEnd)
+      return -1;
+    int64_t last = Scan(tgt, scanned, windowEnd, state);
+    scanned = (last < 0) ? windowEnd : last + 1;
+    return last;
+  }
+
+  const char* filter_algo(const char* text, int64_t textLen, MyersState& state, int* matchLength) const {
+    const uint8_t* tgt = (const uint8_t*)text;
+    const int pieceCount = pieceCount_;
+    int maxPieceLen = 0;
+    for (int p = 0; p < pieceCount; p++)
+      maxPieceLen = max(maxPieceLen, pieceLen_[p]);
+
+    typename V::Type first[kMaxPieceCount];
+    typename V::Type firstAlt[kMaxPieceCount];
+    typename V::Type last[kMaxPieceCount];
+    typename V::Type lastAlt[kMaxPieceCount];
+    const uint8_t* pat = (const uint8_t*)pattern_;
+    for (int p = 0; p < pieceCount; p++) {
+      uint8_t firstChar = Traits::FetchByte(pat, pieceOffset_[p]);
+      uint8_t lastChar = Traits::FetchByte(pat, pieceOffset_[p] + pieceLen_[p] - 1);
+      first[p] = V::Set1(firstChar);
+      firstAlt[p] = V::Set1(ToUpper(firstChar));
+      last[p] = V::Set1(lastChar);
+      lastAlt[p] = V::Set1(ToUpper(lastChar));
+    }
+
+    // The text before |scanned| has been processed by |state|.
+    int64_t scanned = 0;
+    int64_t matchLast = -1;
+    int64_t i = 0;
+    const int64_t blockLimit = textLen - maxPieceLen - (V::kSize - 1);
+    for (; i <= blockLimit && matchLast < 0; i += V::kSize) {
+      typename V::Type eq = V::And(
+        SimdLiteralCompare<T>::template Equal<V>(V::Load(tgt + i), first[0], firstAlt[0]),
+        SimdLiteralCompare<T>::template Equal<V>(V::Load(tgt + i + pieceLen_[0] - 1), last[0], lastAlt[0]));
+      for (int p = 1; p < pieceCount; p++) {
+        eq = V::Or(eq, V::And(
+          SimdLiteralCompare<T>::template Equal<V>(V::Load(tgt + i), first[p], firstAlt[p]),
+          SimdLiteralCompare<T>::template Equal<V>(V::Load(tgt + i + pieceLen_[p] - 1), last[p], lastAlt[p])));
+      }
+      unsigned long mask = V::MoveMask(eq);
+      while (mask) {
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        mask &= mask - 1;
+        int64_t position = i + bit;
+        if (!IsPieceAt(tgt, textLen, position))
+          continue;
+        matchLast = ScanCandidate(tgt, textLen, position, scanned, state);
+        if (matchLast >= 0)
+          break;
+      }
+    }
+    V::Leave();
+
+    // Remaining positions (less than one block)
+    for (; i < textLen && matchLast < 0; i++) {
+      if (IsPieceAt(tgt, textLen, i))
+        matchLast = ScanCandidate(tgt, textLen, i, scanned, state);
+    }
+
+    if (matchLast < 0)
+      return NULL;
+    return ReportMatch(text, textLen, matchLast, state, matchLength);
+  }
+
+  // Returns the start of the best alignment of the pattern with the text
+  // ending at |end|, computed with the edit distance matrix of the reversed
+  // pattern and text. Among starts at the same distance, the one giving a
+  // match of the pattern length (or closest to it) is preferred.
+  int64_t FindMatchStart(const uint8_t* text, int64_t end) const {
+    const int patternLen = patternLen_;
+    const int window = static_cast<int>(min(end, int64_t(patternLen + maxErrors_)));
+    const uint8_t* pat = (const uint8_t*)pattern_;
+
+    // distance[j]: edit distance of the last |i| characters of the pattern
+    // to the last |j| characters of the text.
+    int distance[kMaxPatternLength + kMaxPieceCount];
+    for (int j = 0; j <= window; j++)
+      distance[j] = j;
+    for (int i = 1; i <= patternLen; i++) {
+      uint8_t patternChar = Traits::FetchByte(pat, patternLen - i);
+      int diagonal = distance[0];
+      distance[0] = i;
+      for (int j = 1; j <= window; j++) {
+        int substitution = diagonal + (Traits::FetchByte(text, end - j) != patternChar);
+        diagonal = distance[j];
+        distance[j] = min(substitution, min(distance[j], distance[j - 1]) + 1);
+      }
+    }
+
+    int bestLength = 0;
+    for (int j = 1; j <= window; j++) {
+      if (distance[j] < distance[bestLength] ||
+          (distance[j] == distance[bestLength] && abs(j - patternLen) < abs(bestLength - patternLen))) {
+        bestLength = j;
+      }
+    }
+    return end - bestLength;
+  }
+
+  const char* pattern_;
+  int patternLen_;
+  int maxErrors_;
+  // Bit i of |peq_[ch]| is set if character |ch| matches pattern[i].
+  uint64_t peq_[kAlphabetLen];
+  // The pieces of the pattern searched to find candidate matches, or none
+  // if |pieceCount_| is 0.
+  int pieceCount_;
+  int pieceOffset_[kMaxPieceCount];
+  int pieceLen_[kMaxPieceCount];
+};
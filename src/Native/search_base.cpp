@@ -10,39 +10,10 @@
 
 #include "search_base.h"
 
-namespace {
-
-bool IsWordCharacter(char ch) {
-  return 
-    (ch >= 'a' && ch <= 'z') ||
-    (ch >= 'A' && ch <= 'Z') ||
-    (ch >= '0' && ch <= '9') ||
-    (ch == '_');
+AsciiSearchBase::AsciiSearchBase()
+    : findNext_(nullptr),
+      count_(nullptr) {
 }
-
-bool IsWholeWordMatch(AsciiSearchBase::SearchParams* searchParams) {
-  const char* start = searchParams->MatchStart - 1;
-  char startCh = 0;
-  if (start >= searchParams->TextStart) {
-    startCh = *(searchParams->MatchStart -1);
-  }
-  if (IsWordCharacter(startCh))
-    return false;
-
-  const char* end = searchParams->MatchStart + searchParams->MatchLength;
-  char endCh = 0;
-  if (end < searchParams->TextStart + searchParams->TextLength) {
-    endCh = *end;
-  }
-  if (IsWordCharacter(endCh))
-    return false;
-
-  return true;
-}
-
-}
-
-AsciiSearchBase::AsciiSearchBase() {}
 AsciiSearchBase::~AsciiSearchBase() {}
 
 void AsciiSearchBase::StartSearch(
@@ -51,25 +22,121 @@ void AsciiSearchBase::StartSearch(
   SearchOptions options,
   SearchCreateResult& result) {
   this->StartSearchWorker(pattern, patternLen, options, result);
+  if (findNext_ != nullptr)
+    return;
+
   if (options & kMatchWholeWord) {
     findNext_ = &AsciiSearchBase::FindNextWholeWord;
+    count_ = &AsciiSearchBase::CountWholeWord;
   } else {
-    findNext_ = &AsciiSearchBase::FindNextWorker;
+    findNext_ = &AsciiSearchBase::FindNextVirtual;
+    count_ = &AsciiSearchBase::CountVirtual;
+  }
+}
+
+void AsciiSearchBase::SetSearchFunctions(FindNextFunction findNext, CountFunction count) {
+  findNext_ = findNext;
+  count_ = count;
+}
+
+void AsciiSearchBase::FindNext(SearchParams64* searchParams) {
+  findNext_(this, searchParams);
+}
+
+int AsciiSearchBase::FindAll(
+    SearchParams64* searchParams,
+    SearchMatch64* matches,
+    int capacity) {
+  int count = 0;
+  while (count < capacity) {
+    findNext_(this, searchParams);
+    if (searchParams->MatchStart == nullptr)
+      break;
+
+    matches[count].Offset = searchParams->MatchStart - searchParams->TextStart;
+    matches[count].Length = searchParams->MatchLength;
+    count++;
+  }
+  return count;
+}
+
+int AsciiSearchBase::FindAllFragments(
+    const SearchFragment64* fragments,
+    int fragmentCount,
+    int* fragmentIndex,
+    SearchParams64* searchParams,
+    SearchFragmentMatch64* matches,
+    int capacity) {
+  int count = 0;
+  while (count < capacity && *fragmentIndex < fragmentCount) {
+    // Start searching the next fragment, unless the search is cancelled.
+    if (searchParams->MatchStart == nullptr) {
+      if (IsCancelled(searchParams)) {
+        *fragmentIndex = fragmentCount;
+        break;
+      }
+      searchParams->TextStart = fragments[*fragmentIndex].TextStart;
+      searchParams->TextLength = fragments[*fragmentIndex].TextLength;
+    }
+
+    findNext_(this, searchParams);
+    if (searchParams->MatchStart == nullptr) {
+      (*fragmentIndex)++;
+      continue;
+    }
+
+    matches[count].FragmentIndex = *fragmentIndex;
+    matches[count].Offset = searchParams->MatchStart - searchParams->TextStart;
+    matches[count].Length = searchParams->MatchLength;
+    count++;
+  }
+  return count;
+}
+
+int AsciiSearchBase::Count(SearchParams64* searchParams, int maxCount) {
+  return count_(this, searchParams, maxCount);
+}
+
+int AsciiSearchBase::CountWorker(SearchParams64* searchParams, int maxCount) {
+  return CountFindNext(searchParams, maxCount);
+}
+
+int AsciiSearchBase::CountFindNext(SearchParams64* searchParams, int maxCount) {
+  int count = 0;
+  while (count < maxCount) {
+    findNext_(this, searchParams);
+    if (searchParams->MatchStart == nullptr)
+      return count;
+    count++;
   }
+  CancelSearch(searchParams);
+  searchParams->MatchStart = nullptr;
+  return count;
 }
 
-void AsciiSearchBase::FindNext(SearchParams* searchParams) {
-  (this->*findNext_)(searchParams);
+void AsciiSearchBase::FindNextVirtual(AsciiSearchBase* search, SearchParams64* searchParams) {
+  search->FindNextWorker(searchParams);
 }
 
-void AsciiSearchBase::FindNextWholeWord(SearchParams* searchParams) {
+void AsciiSearchBase::FindNextWholeWord(AsciiSearchBase* search, SearchParams64* searchParams) {
   while (true) {
-    this->FindNextWorker(searchParams);
+    search->FindNextWorker(searchParams);
     if (searchParams->MatchStart == nullptr)
       break;
 
-    if (IsWholeWordMatch(searchParams))
+    if (IsWholeWordMatch(searchParams->TextStart,
+                         searchParams->TextStart + searchParams->TextLength,
+                         searchParams->MatchStart,
+                         searchParams->MatchLength)) {
       break;
+    }
   }
 }
 
+int AsciiSearchBase::CountVirtual(AsciiSearchBase* search, SearchParams64* searchParams, int maxCount) {
+  return search->CountWorker(searchParams, maxCount);
+}
+
+int AsciiSearchBase::CountWholeWord(AsciiSearchBase* search, SearchParams64* searchParams, int maxCount) {
+  return search->CountFindNext(searchParams, maxCount);
+}
@@ -12,14 +12,93 @@ class AsciiSearchBase {
     // Search is case sensitive
     kMatchCase = 0x0001,
     kMatchWholeWord = 0x0002,
+    // Case insensitive search folds each byte inside the search algorithm
+    // instead of folding blocks of text ahead of time (for benchmarking
+    // purposes).
+    kPerByteCaseFolding = 0x0004,
+    // Regular expressions (|RegexSearch|) are always searched with
+    // std::regex, instead of RE2 when it matches them the same way (for
+    // testing and benchmarking purposes).
+    kNoRegexTranslation = 0x0008,
+    // Number of errors (inserted, deleted or substituted characters) allowed
+    // in the matches of approximate searches, see |ApproximateSearch|.
+    kMaxErrorsMask = 0x00F0,
+    kMaxErrorsShift = 4,
   };
 
+  // Number of characters (or regular expression steps) scanned between two
+  // checks of |SearchParams64::Cancelled|.
+  enum { kCancellationCheckInterval = 64 * 1024 };
+
+  struct SearchParams64 {
+    const char* TextStart;
+    int64_t TextLength;
+    const char* MatchStart;
+    int64_t MatchLength;
+    // For algorithms searching for multiple patterns at once, the index of
+    // the pattern found at |MatchStart|.
+    int MatchPatternIndex;
+    void* SearchBuffer;
+    // Optional range of text containing the searched text, which algorithms
+    // may look at beyond the boundaries of the searched text, e.g. to find
+    // the extent of lines. |ContextStart| is null if not available.
+    const char* ContextStart;
+    int64_t ContextLength;
+    // Optional flag set to a non-zero value (e.g. by another thread) to stop
+    // the search. Algorithms that may scan a lot of text without finding a
+    // match check it regularly, and report no match once it is set. Null if
+    // the search cannot be cancelled.
+    const volatile int* Cancelled;
+  };
+
+  // A match found by |FindAll|, relative to |SearchParams64::TextStart|.
+  struct SearchMatch64 {
+    int64_t Offset;
+    int64_t Length;
+  };
+
+  // A range of text searched by |FindAllFragments|.
+  struct SearchFragment64 {
+    const char* TextStart;
+    int64_t TextLength;
+  };
+
+  // A match found by |FindAllFragments|, relative to the |TextStart| of the
+  // fragment at |FragmentIndex|.
+  struct SearchFragmentMatch64 {
+    int FragmentIndex;
+    int64_t Offset;
+    int64_t Length;
+  };
+
+  // The 32-bit versions of the structures above, used by the original
+  // exports of the DLL, which are limited to texts of less than 2GB.
   struct SearchParams {
     const char* TextStart;
     int TextLength;
     const char* MatchStart;
     int MatchLength;
+    int MatchPatternIndex;
     void* SearchBuffer;
+    const char* ContextStart;
+    int ContextLength;
+    const volatile int* Cancelled;
+  };
+
+  struct SearchMatch {
+    int Offset;
+    int Length;
+  };
+
+  struct SearchFragment {
+    const char* TextStart;
+    int TextLength;
+  };
+
+  struct SearchFragmentMatch {
+    int FragmentIndex;
+    int Offset;
+    int Length;
   };
 
   struct SearchCreateResult {
@@ -38,9 +117,69 @@ class AsciiSearchBase {
   virtual ~AsciiSearchBase();
 
   void StartSearch(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result);
-  void FindNext(SearchParams* searchParams);
-  virtual void CancelSearch(SearchParams* searchParams) {}
+  void FindNext(SearchParams64* searchParams);
+  // Calls |FindNext| until the end of the text is reached or |capacity|
+  // matches have been stored in |matches|, and returns the number of matches
+  // stored. If the return value is |capacity|, calling |FindAll| again with
+  // the same |searchParams| resumes the search after the last match.
+  int FindAll(SearchParams64* searchParams, SearchMatch64* matches, int capacity);
+  // Counts the matches from the current position of |searchParams| to the
+  // end of the text, stopping at |maxCount| matches (e.g. 1 to check if
+  // there is any match). No match is reported in |searchParams|, and no
+  // search state is left to cancel.
+  int Count(SearchParams64* searchParams, int maxCount);
+  // Searches each fragment of |fragments| in turn, starting at
+  // |*fragmentIndex|, until all fragments have been searched or |capacity|
+  // matches have been stored in |matches|, and returns the number of matches
+  // stored. |searchParams| holds the state of the search in the current
+  // fragment: its |MatchStart| must be null on the first call. If the return
+  // value is |capacity|, calling |FindAllFragments| again with the same
+  // |fragmentIndex| and |searchParams| resumes the search after the last
+  // match. The fragments left are skipped once the search is cancelled.
+  int FindAllFragments(
+      const SearchFragment64* fragments,
+      int fragmentCount,
+      int* fragmentIndex,
+      SearchParams64* searchParams,
+      SearchFragmentMatch64* matches,
+      int capacity);
+  virtual void CancelSearch(SearchParams64* searchParams) {}
   virtual int GetSearchBufferSize() { return 0; }
+  // Number of characters before and after a match (or a candidate match)
+  // that the algorithm may look at in |SearchParams64::ContextStart|, e.g.
+  // to find the extent of lines. See |StreamingSearch|.
+  virtual int GetContextLength() { return 0; }
+  // Returns the end of the last candidate match the search went through
+  // before the match found by the last call to |FindNext| (or before the
+  // end of the text), including the candidates it rejected without
+  // reporting them, e.g. wildcard matches missing entries. Searching again
+  // from anywhere between there and the match finds the same matches. Null
+  // if the search went through no such candidate, or if it reports all its
+  // candidates. See |StreamingSearch|.
+  virtual const char* GetCandidateEnd(const SearchParams64* searchParams) { return nullptr; }
+
+  static bool IsCancelled(const SearchParams64* searchParams) {
+    return searchParams->Cancelled != nullptr && *searchParams->Cancelled != 0;
+  }
+
+  static bool IsWordCharacter(uint8_t ch) {
+    return
+      (ch >= 'a' && ch <= 'z') ||
+      (ch >= 'A' && ch <= 'Z') ||
+      (ch >= '0' && ch <= '9') ||
+      (ch == '_');
+  }
+
+  // Returns true if the |matchLength| characters at |matchStart| are neither
+  // preceded nor followed by a word character inside [textStart, textEnd).
+  static bool IsWholeWordMatch(const char* textStart, const char* textEnd, const char* matchStart, int64_t matchLength) {
+    if (matchStart > textStart && IsWordCharacter(matchStart[-1]))
+      return false;
+    const char* matchEnd = matchStart + matchLength;
+    if (matchEnd < textEnd && IsWordCharacter(*matchEnd))
+      return false;
+    return true;
+  }
 
   static const uint8_t read_byte(const uint8_t* text, int index, bool matchCase) {
     uint8_t value = text[index];
@@ -54,21 +193,39 @@ class AsciiSearchBase {
 
 protected:
   virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) = 0;
-  virtual void FindNextWorker(SearchParams* searchParams) = 0;
+  virtual void FindNextWorker(SearchParams64* searchParams) = 0;
+  // Counts matches without reporting them, see |Count|. The default
+  // implementation calls |FindNextWorker| for each match. Algorithms can
+  // override it to count matches without leaving their inner loop.
+  virtual int CountWorker(SearchParams64* searchParams, int maxCount);
+
+  typedef void (*FindNextFunction)(AsciiSearchBase* search, SearchParams64* searchParams);
+  typedef int (*CountFunction)(AsciiSearchBase* search, SearchParams64* searchParams, int maxCount);
+  // Sets the functions called by |FindNext| and |Count|, which must be
+  // called before |StartSearch|. By default, |FindNextWorker| and
+  // |CountWorker| are called through virtual calls, and matches that are not
+  // whole words are skipped by calling |FindNextWorker| again. See
+  // |AsciiSearchKernel|.
+  void SetSearchFunctions(FindNextFunction findNext, CountFunction count);
 
   enum { kAlphabetLen = 256 };
 
 private:
-  void FindNextWholeWord(SearchParams* searchParams);
+  int CountFindNext(SearchParams64* searchParams, int maxCount);
+
+  static void FindNextVirtual(AsciiSearchBase* search, SearchParams64* searchParams);
+  static void FindNextWholeWord(AsciiSearchBase* search, SearchParams64* searchParams);
+  static int CountVirtual(AsciiSearchBase* search, SearchParams64* searchParams, int maxCount);
+  static int CountWholeWord(AsciiSearchBase* search, SearchParams64* searchParams, int maxCount);
 
 private:
-  typedef void (AsciiSearchBase::*FindNextFunction)(SearchParams* searchParams);
   FindNextFunction findNext_;
+  CountFunction count_;
 };
 
 template <typename T>
 struct AsciiSearchBaseTemplateCaseSensitive {
-  static const uint8_t FetchByte(const uint8_t* text, int index);
+  static const uint8_t FetchByte(const uint8_t* text, int64_t index);
 };
 
 struct CaseSensitive {};
@@ -76,21 +233,70 @@ struct CaseInsensitive {};
 
 template <>
 struct AsciiSearchBaseTemplateCaseSensitive<CaseSensitive> {
-  static const uint8_t FetchByte(const uint8_t* text, int index) {
+  static const uint8_t FetchByte(const uint8_t* text, int64_t index) {
     return text[index];
   }
 };
 
 template <>
 struct AsciiSearchBaseTemplateCaseSensitive<CaseInsensitive> {
-  static const uint8_t FetchByte(const uint8_t* text, int index) {
+  static const uint8_t FetchByte(const uint8_t* text, int64_t index) {
     uint8_t value = text[index];
     return (value >= 'A' && value <= 'Z') ? value |= 0x20 : value;
   }
 };
 
-template <typename T, typename TTraits = AsciiSearchBaseTemplateCaseSensitive<T> >
+struct AnyWord {};
+struct WholeWord {};
+
+template <typename W>
+struct AsciiSearchBaseTemplateWordMode {
+  static bool IsWordMatch(const char* textStart, const char* textEnd, const char* matchStart, int matchLength);
+};
+
+template <>
+struct AsciiSearchBaseTemplateWordMode<AnyWord> {
+  static const bool kWholeWord = false;
+  static bool IsWordMatch(const char* textStart, const char* textEnd, const char* matchStart, int matchLength) {
+    return true;
+  }
+};
+
+template <>
+struct AsciiSearchBaseTemplateWordMode<WholeWord> {
+  static const bool kWholeWord = true;
+  static bool IsWordMatch(const char* textStart, const char* textEnd, const char* matchStart, int matchLength) {
+    return AsciiSearchBase::IsWholeWordMatch(textStart, textEnd, matchStart, matchLength);
+  }
+};
+
+// Base class of the search algorithms specialized at compile time on their
+// case mode (|CaseSensitive| or |CaseInsensitive|) and word mode (|AnyWord|
+// or |WholeWord|).
+template <typename T, typename W = AnyWord>
 class AsciiSearchBaseTemplate : public AsciiSearchBase {
  public:
-  typedef TTraits Traits;
+  typedef AsciiSearchBaseTemplateCaseSensitive<T> Traits;
+  typedef AsciiSearchBaseTemplateWordMode<W> WordTraits;
+};
+
+// Search algorithm |S| (an |AsciiSearchBaseTemplate| specialization), with
+// |FindNext| and |Count| calling the |S| implementations directly instead of
+// going through virtual calls. The word mode of |S| must match the
+// |kMatchWholeWord| option passed to |StartSearch|.
+template <typename S>
+class AsciiSearchKernel : public S {
+ public:
+  AsciiSearchKernel() {
+    this->SetSearchFunctions(&FindNextKernel, &CountKernel);
+  }
+
+ private:
+  static void FindNextKernel(AsciiSearchBase* search, AsciiSearchBase::SearchParams64* searchParams) {
+    static_cast<AsciiSearchKernel*>(search)->S::FindNextWorker(searchParams);
+  }
+
+  static int CountKernel(AsciiSearchBase* search, AsciiSearchBase::SearchParams64* searchParams, int maxCount) {
+    return static_cast<AsciiSearchKernel*>(search)->S::CountWorker(searchParams, maxCount);
+  }
 };
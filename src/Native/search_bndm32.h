@@ -10,8 +10,8 @@
 
 #include "search_base.h"
 
-template<typename T>
-class Bndm32Search : public AsciiSearchBaseTemplate<T> {
+template<typename T, typename W = AnyWord>
+class Bndm32Search : public AsciiSearchBaseTemplate<T, W> {
  public:
   Bndm32Search()
       : pattern_(NULL),
@@ -29,16 +29,15 @@ class Bndm32Search : public AsciiSearchBaseTemplate<T> {
       setbit32(&maskv_[Traits::FetchByte(pat, i)], patternLen - 1 - i);
   }
 
-  virtual void FindNextWorker(SearchParams* searchParams) OVERRIDE {
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
     const char* text = searchParams->TextStart;
-    int textLen = searchParams->TextLength;
+    int64_t textLen = searchParams->TextLength;
     if (searchParams->MatchStart != nullptr) {
       text = searchParams->MatchStart + searchParams->MatchLength;
-      // TODO(rpaquay): 2GB Limit
-      textLen = (int)(searchParams->TextStart + searchParams->TextLength - text);
+      textLen = searchParams->TextStart + searchParams->TextLength - text;
     }
 
-    searchParams->MatchStart = bndm32_algo(text, textLen, pattern_, patternLen_, maskv_);
+    searchParams->MatchStart = bndm32_algo(text, textLen, pattern_, patternLen_, maskv_, searchParams->TextStart);
 
     if (searchParams->MatchStart != nullptr) {
       searchParams->MatchLength = patternLen_;
@@ -55,16 +54,23 @@ class Bndm32Search : public AsciiSearchBaseTemplate<T> {
     v[p >> 5] |= one << (p & 31);
   }
 
-  static const char *bndm32_algo(const char *text, int textLen,
+  static const char *bndm32_algo(const char *text, int64_t textLen,
                                  const char *pattern, int patternLen,
-                                 uint32_t* maskv) {
+                                 uint32_t* maskv,
+                                 const char* textStart) {
     uint8_t *tgt = (uint8_t*)text;
     int j;
 
-    for (int i = 0; i <= textLen - patternLen; i += j) {
+    for (int64_t i = 0; i <= textLen - patternLen; i += j) {
       uint32_t mask = maskv[Traits::FetchByte(tgt, i + patternLen - 1)];
       for (j = patternLen; mask;) {
-        if (!--j) return text + i;
+        if (!--j) {
+          if (WordTraits::IsWordMatch(textStart, text + textLen, text + i, patternLen))
+            return text + i;
+          // Skip the match, as |FindNextWholeWord| would.
+          j = patternLen;
+          break;
+        }
         mask = (mask << 1) & maskv[Traits::FetchByte(tgt, i + j - 1)];
       }
     }
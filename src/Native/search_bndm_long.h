@@ -0,0 +1,142 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "search_base.h"
+
+// BNDM search for patterns of any length (i.e. longer than 64 characters).
+//
+// BNDM is run on a window of 64 characters of the pattern (the bit vector
+// of a 64-bit word), and each occurrence of the window is verified against
+// the whole pattern. The window with the most distinct characters is used,
+// as it is the least likely to produce false positives, and distinct
+// characters also allow longer shifts.
+template<typename T, typename W = AnyWord>
+class BndmLongSearch : public AsciiSearchBaseTemplate<T, W> {
+ public:
+  enum { kWindowLength = 64 };
+
+  BndmLongSearch()
+      : pattern_(NULL),
+        patternLen_(0),
+        windowOffset_(0),
+        windowLen_(0) {
+    memset(maskv_, 0, sizeof(maskv_));
+  }
+
+  void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE {
+    pattern_ = pattern;
+    patternLen_ = patternLen;
+    windowLen_ = min(patternLen, (int)kWindowLength);
+    windowOffset_ = FindWindowOffset((const uint8_t*)pattern, patternLen, windowLen_);
+
+    const uint8_t *window = (const uint8_t*)pattern + windowOffset_;
+    for (int i = 0; i < windowLen_; ++i)
+      setbit64(&maskv_[Traits::FetchByte(window, i)], windowLen_ - 1 - i);
+  }
+
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
+    const char* text = searchParams->TextStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = searchParams->MatchStart + searchParams->MatchLength;
+      textLen = searchParams->TextStart + searchParams->TextLength - text;
+    }
+
+    searchParams->MatchStart = bndm_long_algo(text, textLen, searchParams->TextStart);
+
+    if (searchParams->MatchStart != nullptr) {
+      searchParams->MatchLength = patternLen_;
+    }
+  }
+
+ private:
+  // setbit: set a bit in a LSB-first 64bit word in memory.
+  static void setbit64(uint64_t *v, int p) {
+    assert(p >= 0);
+    assert(p <= 63);
+
+    uint64_t one = 1;
+    v[p >> 6] |= one << (p & 63);
+  }
+
+  // Returns the offset of the window of |windowLen| characters of |pattern|
+  // with the most distinct characters.
+  static int FindWindowOffset(const uint8_t* pattern, int patternLen, int windowLen) {
+    int counts[kAlphabetLen] = { 0 };
+    int distinct = 0;
+    for (int i = 0; i < windowLen; i++) {
+      if (counts[Traits::FetchByte(pattern, i)]++ == 0)
+        distinct++;
+    }
+
+    int bestOffset = 0;
+    int bestDistinct = distinct;
+    for (int i = windowLen; i < patternLen; i++) {
+      if (counts[Traits::FetchByte(pattern, i)]++ == 0)
+        distinct++;
+      if (--counts[Traits::FetchByte(pattern, i - windowLen)] == 0)
+        distinct--;
+      if (distinct > bestDistinct) {
+        bestDistinct = distinct;
+        bestOffset = i - windowLen + 1;
+      }
+    }
+    return bestOffset;
+  }
+
+  bool Verify(const uint8_t* text) const {
+    const uint8_t* pat = (const uint8_t*)pattern_;
+    for (int j = 0; j < patternLen_; j++) {
+      if (Traits::FetchByte(text, j) != Traits::FetchByte(pat, j))
+        return false;
+    }
+    return true;
+  }
+
+  const char *bndm_long_algo(const char *text, int64_t textLen, const char* textStart) const {
+    if (textLen < patternLen_)
+      return NULL;
+
+    // Occurrences of the window are searched in the part of the text where
+    // the whole pattern fits around them.
+    uint8_t *tgt = (uint8_t*)text + windowOffset_;
+    const int64_t windowTextLen = textLen - (patternLen_ - windowLen_);
+    const int windowLen = windowLen_;
+    int j;
+
+    for (int64_t i = 0; i <= windowTextLen - windowLen; i += j) {
+      uint64_t mask = maskv_[Traits::FetchByte(tgt, i + windowLen - 1)];
+      for (j = windowLen; mask;) {
+        if (!--j) {
+          if (Verify(tgt + i - windowOffset_)) {
+            if (WordTraits::IsWordMatch(textStart, text + textLen, text + i, patternLen_))
+              return text + i;
+            // Skip the match, as |FindNextWholeWord| would.
+            j = patternLen_;
+            break;
+          }
+          // Skip to the next position
+          j = 1;
+          break;
+        }
+        mask = (mask << 1) & maskv_[Traits::FetchByte(tgt, i + j - 1)];
+      }
+    }
+
+    return NULL;
+  }
+
+  const char *pattern_;
+  int patternLen_;
+  int windowOffset_;
+  int windowLen_;
+  uint64_t maskv_[kAlphabetLen];
+};
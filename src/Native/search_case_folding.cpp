@@ -0,0 +1,108 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "search_case_folding.h"
+
+#include <stddef.h>
+
+#include "ascii_fold.h"
+
+namespace {
+
+const int kWindowSize = 4096;
+
+// Layout of the search buffer.
+struct FoldedWindow {
+  // The start of the window in the original text, or nullptr if the window
+  // has not been filled yet.
+  const char* source;
+  int length;
+  char text[kWindowSize];
+};
+
+}  // namespace
+
+CaseFoldingSearch::CaseFoldingSearch(AsciiSearchBase* search)
+    : search_(search) {
+}
+
+CaseFoldingSearch::~CaseFoldingSearch() {
+  delete search_;
+}
+
+int CaseFoldingSearch::GetSearchBufferSize() {
+  return sizeof(FoldedWindow);
+}
+
+void CaseFoldingSearch::StartSearchWorker(
+    const char *pattern,
+    int patternLen,
+    SearchOptions options,
+    SearchCreateResult& result) {
+  if (patternLen > kMaxPatternLength) {
+    result.SetError(E_INVALIDARG, "Pattern is too long for case folding search");
+    return;
+  }
+  foldedPattern_.resize(patternLen);
+  AsciiFoldToLower(pattern, &foldedPattern_[0], patternLen);
+
+  // Whole word matching is performed by this instance on the original text.
+  int searchOptions = (options | kMatchCase) & ~kMatchWholeWord;
+  search_->StartSearch(
+    foldedPattern_.data(),
+    patternLen,
+    static_cast<SearchOptions>(searchOptions),
+    result);
+}
+
+void CaseFoldingSearch::FindNextWorker(SearchParams64* searchParams) {
+  FoldedWindow* window = reinterpret_cast<FoldedWindow*>(searchParams->SearchBuffer);
+  const int patternLen = static_cast<int>(foldedPattern_.size());
+  const char* textEnd = searchParams->TextStart + searchParams->TextLength;
+  const char* start = searchParams->TextStart;
+  if (searchParams->MatchStart == nullptr) {
+    window->source = nullptr;
+  } else {
+    start = searchParams->MatchStart + searchParams->MatchLength;
+  }
+
+  while (true) {
+    // Refill the window unless it contains all the text needed to look for
+    // a match starting at |start|.
+    const char* windowEnd = window->source + window->length;
+    bool windowValid =
+      window->source != nullptr &&
+      window->source <= start &&
+      (start + patternLen <= windowEnd || windowEnd == textEnd);
+    if (!windowValid) {
+      window->source = start;
+      window->length = static_cast<int>(min(textEnd - start, static_cast<ptrdiff_t>(kWindowSize)));
+      AsciiFoldToLower(start, window->text, window->length);
+      windowEnd = window->source + window->length;
+    }
+
+    const int offset = static_cast<int>(start - window->source);
+    SearchParams64 params = SearchParams64();
+    params.TextStart = window->text + offset;
+    params.TextLength = window->length - offset;
+    search_->FindNext(&params);
+    if (params.MatchStart != nullptr) {
+      searchParams->MatchStart = window->source + (params.MatchStart - window->text);
+      searchParams->MatchLength = params.MatchLength;
+      return;
+    }
+
+    if (windowEnd == textEnd) {
+      searchParams->MatchStart = nullptr;
+      searchParams->MatchLength = 0;
+      return;
+    }
+
+    // Next window overlaps the current one so that matches spanning both
+    // windows are found.
+    start = max(start, windowEnd - max(patternLen - 1, 0));
+  }
+}
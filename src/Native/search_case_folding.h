@@ -0,0 +1,37 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <string>
+
+#include "search_base.h"
+
+// Case insensitive search adapter: The text is folded to lower case one
+// window at a time using vector instructions (see |AsciiFoldToLower|) and the
+// folded window is searched with a case sensitive algorithm. This avoids
+// folding each byte inside the inner loop of the algorithm.
+//
+// The window is stored in the search buffer, so it is reused for consecutive
+// matches in the same text.
+class CaseFoldingSearch : public AsciiSearchBase {
+ public:
+  // Patterns must be significantly shorter than the folding window.
+  enum { kMaxPatternLength = 256 };
+
+  // Takes ownership of |search|, which must be a case sensitive algorithm
+  // that does not use a search buffer.
+  explicit CaseFoldingSearch(AsciiSearchBase* search);
+  virtual ~CaseFoldingSearch();
+
+  virtual int GetSearchBufferSize() OVERRIDE;
+
+ protected:
+  virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+
+ private:
+  AsciiSearchBase* search_;
+  std::string foldedPattern_;
+};
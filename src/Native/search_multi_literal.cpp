@@ -0,0 +1,188 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "search_multi_literal.h"
+
+#include <string.h>
+
+#include <deque>
+
+namespace {
+
+const int kRootState = 0;
+const int kNoState = -1;
+
+uint8_t FoldByte(uint8_t value, bool matchCase) {
+  return AsciiSearchBase::read_byte(&value, 0, matchCase);
+}
+
+}  // namespace
+
+MultiLiteralSearch::MultiLiteralSearch()
+    : maxPatternLen_(0) {
+  memset(startBytes_, 0, sizeof(startBytes_));
+}
+
+int MultiLiteralSearch::AddState(int depth) {
+  int state = static_cast<int>(outputs_.size());
+  transitions_.resize(transitions_.size() + kAlphabetLen, kNoState);
+  outputs_.push_back(-1);
+  outputLinks_.push_back(kRootState);
+  depths_.push_back(depth);
+  return state;
+}
+
+void MultiLiteralSearch::AddPattern(
+    const uint8_t* pattern,
+    int patternLen,
+    int patternIndex,
+    bool matchCase) {
+  int state = kRootState;
+  for (int i = 0; i < patternLen; i++) {
+    uint8_t ch = FoldByte(pattern[i], matchCase);
+    int next = transitions_[state * kAlphabetLen + ch];
+    if (next == kNoState) {
+      next = AddState(i + 1);
+      transitions_[state * kAlphabetLen + ch] = next;
+    }
+    state = next;
+  }
+  // Keep the first pattern in case of duplicates.
+  if (outputs_[state] < 0)
+    outputs_[state] = patternIndex;
+}
+
+void MultiLiteralSearch::BuildTransitions(bool matchCase) {
+  // Breadth first traversal computing suffix (failure) links, turning the
+  // trie into a complete automaton.
+  std::vector<int> suffixLinks(outputs_.size(), kRootState);
+  std::deque<int> queue;
+  for (int ch = 0; ch < kAlphabetLen; ch++) {
+    int& next = transitions_[kRootState * kAlphabetLen + ch];
+    if (next == kNoState) {
+      next = kRootState;
+    } else {
+      queue.push_back(next);
+    }
+  }
+
+  while (!queue.empty()) {
+    int state = queue.front();
+    queue.pop_front();
+    int suffix = suffixLinks[state];
+    outputLinks_[state] = (outputs_[suffix] >= 0) ? suffix : outputLinks_[suffix];
+    for (int ch = 0; ch < kAlphabetLen; ch++) {
+      int& next = transitions_[state * kAlphabetLen + ch];
+      int suffixNext = transitions_[suffix * kAlphabetLen + ch];
+      if (next == kNoState) {
+        next = suffixNext;
+      } else {
+        suffixLinks[next] = suffixNext;
+        queue.push_back(next);
+      }
+    }
+  }
+
+  // For case insensitive search, upper case letters behave as their lower
+  // case counterpart, so there is no need to fold the text.
+  if (!matchCase) {
+    for (size_t state = 0; state < outputs_.size(); state++) {
+      for (int ch = 'A'; ch <= 'Z'; ch++) {
+        transitions_[state * kAlphabetLen + ch] =
+          transitions_[state * kAlphabetLen + (ch | 0x20)];
+      }
+    }
+  }
+
+  for (int ch = 0; ch < kAlphabetLen; ch++) {
+    startBytes_[ch] = (transitions_[kRootState * kAlphabetLen + ch] != kRootState);
+  }
+}
+
+void MultiLiteralSearch::StartSearchWorker(
+    const char *pattern,
+    int patternLen,
+    SearchOptions options,
+    SearchCreateResult& result) {
+  const bool matchCase = (options & kMatchCase) != 0;
+  AddState(0);
+
+  const uint8_t* patternBytes = reinterpret_cast<const uint8_t*>(pattern);
+  int patternIndex = 0;
+  int start = 0;
+  for (int i = 0; i <= patternLen; i++) {
+    if (i == patternLen || pattern[i] == kPatternSeparator) {
+      int len = i - start;
+      if (len > 0) {
+        AddPattern(patternBytes + start, len, patternIndex, matchCase);
+        maxPatternLen_ = max(maxPatternLen_, len);
+      }
+      patternIndex++;
+      start = i + 1;
+    }
+  }
+
+  if (maxPatternLen_ == 0) {
+    result.SetError(E_INVALIDARG, "Pattern list is empty");
+    return;
+  }
+
+  BuildTransitions(matchCase);
+}
+
+void MultiLiteralSearch::FindNextWorker(SearchParams64* searchParams) {
+  const uint8_t* textStart = reinterpret_cast<const uint8_t*>(searchParams->TextStart);
+  const uint8_t* textEnd = textStart + searchParams->TextLength;
+  const uint8_t* current = textStart;
+  if (searchParams->MatchStart != nullptr) {
+    current = reinterpret_cast<const uint8_t*>(searchParams->MatchStart) + searchParams->MatchLength;
+  }
+
+  const int* transitions = &transitions_[0];
+  const uint8_t* bestStart = nullptr;
+  int bestLength = 0;
+  int bestIndex = -1;
+  int state = kRootState;
+  for (; current < textEnd; current++) {
+    if (state == kRootState) {
+      // No match can start before a byte in |startBytes_|, and no pending
+      // match can start before the one we have found already.
+      if (bestStart != nullptr)
+        break;
+      while (current < textEnd && !startBytes_[*current])
+        current++;
+      if (current == textEnd)
+        break;
+    }
+
+    state = transitions[state * kAlphabetLen + *current];
+    int matchState = (outputs_[state] >= 0) ? state : outputLinks_[state];
+    for (; matchState != kRootState; matchState = outputLinks_[matchState]) {
+      int length = depths_[matchState];
+      const uint8_t* start = current + 1 - length;
+      int index = outputs_[matchState];
+      if (bestStart == nullptr || start < bestStart ||
+          (start == bestStart && index < bestIndex)) {
+        bestStart = start;
+        bestLength = length;
+        bestIndex = index;
+      }
+    }
+
+    // All the matches starting at or before |bestStart| have been seen.
+    if (bestStart != nullptr && current + 1 >= bestStart + maxPatternLen_)
+      break;
+  }
+
+  if (bestStart == nullptr) {
+    searchParams->MatchStart = nullptr;
+    searchParams->MatchLength = 0;
+    return;
+  }
+  searchParams->MatchStart = reinterpret_cast<const char*>(bestStart);
+  searchParams->MatchLength = bestLength;
+  searchParams->MatchPatternIndex = bestIndex;
+}
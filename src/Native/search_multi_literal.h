@@ -0,0 +1,49 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "search_base.h"
+
+// Search for any of a set of literal patterns in a single pass over the text,
+// using an Aho-Corasick automaton compiled to a dense transition table.
+//
+// The patterns are passed to |StartSearch| as a single string, separated by
+// |kPatternSeparator|. Matches are reported leftmost first: the match starting
+// at the lowest text position, and for matches starting at the same
+// position, the pattern that comes first in the list.
+// |SearchParams64::MatchPatternIndex| is set to the index of the matching
+// pattern.
+class MultiLiteralSearch : public AsciiSearchBase {
+ public:
+  enum { kPatternSeparator = '\n' };
+
+  MultiLiteralSearch();
+
+ protected:
+  virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+
+ private:
+  int AddState(int depth);
+  void AddPattern(const uint8_t* pattern, int patternLen, int patternIndex, bool matchCase);
+  void BuildTransitions(bool matchCase);
+
+  // Dense transition table: |transitions_[state * kAlphabetLen + byte]|.
+  std::vector<int> transitions_;
+  // The index of the pattern ending at each state, or -1.
+  std::vector<int> outputs_;
+  // The nearest state reachable through suffix links with an output, or 0.
+  std::vector<int> outputLinks_;
+  // The length of the string spelled by each state.
+  std::vector<int> depths_;
+  // Bytes that can start a match, used to skip quickly through the text
+  // while in the root state.
+  bool startBytes_[kAlphabetLen];
+  int maxPatternLen_;
+};
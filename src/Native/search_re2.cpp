@@ -4,30 +4,169 @@
 
 #include "stdafx.h"
 
+#include <string.h>
+
+#include <atomic>
+#include <functional>
 #include <regex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "search_re2.h"
 
+#include "compiled_pattern_cache.h"
 #include "re2/re2_wrapper.h"
 
-class RE2SearchImpl {
+namespace {
+
+// RE2 searches texts of less than 2GB, so larger texts are searched one
+// window at a time. Consecutive windows overlap so that matches spanning
+// both windows are found, unless they are longer than the overlap.
+const int64_t kMaxWindowLength = 1 << 30;
+const int64_t kWindowOverlap = 1 << 20;
+// RE2 offers no way of stopping a search, so the windows are smaller when
+// the search can be cancelled, with the cancellation flag checked between
+// windows.
+const int64_t kCancellableWindowLength = 8 << 20;
+
+// Shortest atom worth searching before running RE2: shorter atoms are found
+// too often to skip much text.
+const int kMinAtomLength = 3;
+// RE2 runs on at least this many characters from the line of an atom, so
+// that the cost of finding atoms and of starting RE2 is amortized over
+// several lines when atoms are frequent.
+const int64_t kMinAtomRangeLength = 64 * 1024;
+
+// Maximum number of matches found by a single call to RE2, see
+// |RE2Search::MatchBatch|.
+const int kMaxBatchMatches = 128;
+
+// Maximum number of compiled clones of the regular expression kept for
+// concurrent searches, see |RE2SearchImpl|.
+const int kMaxClones = 64;
+// Maximum number of clones kept once a search is deleted. Each clone holds
+// its own DFA cache (up to the RE2 memory budget), so the patterns kept in
+// the compiled pattern cache keep only a few warm clones for the next
+// query.
+const int kMaxIdleClones = 2;
+
+// A slot of the clone pool, padded to a cache line so that threads using
+// different slots do not contend.
+struct CloneSlot {
+  std::atomic<RE2Wrapper*> wrapper;
+  char padding[64 - sizeof(std::atomic<RE2Wrapper*>)];
+};
+
+}  // namespace
+
+// RE2 guards the DFA cache of a compiled regular expression with mutexes,
+// so concurrent searches with the same instance stop scaling past a few
+// threads. Each search borrows a private clone instead, compiled on first
+// use and returned to the pool when the search returns. Threads start
+// looking for a clone at a slot derived from their id, so that each thread
+// usually gets the clone it used last, with a warm DFA cache.
+//
+// The clones and the atom search are shared by the searches for the same
+// pattern through the compiled pattern cache, so that successive queries
+// skip compiling the pattern and start with warm DFA caches. The pool is
+// trimmed to |kMaxIdleClones| clones when a search is deleted, which bounds
+// the memory of the cached patterns.
+class RE2SearchImpl : public CompiledPattern {
 public:
-  RE2SearchImpl() : re2_wrapper(nullptr) {
+  RE2SearchImpl() : caseSensitive(false), latin1(false), atomSearch(nullptr), atomBufferSize(0) {
+    for (int i = 0; i < kMaxClones; i++) {
+      clones[i].wrapper = nullptr;
+    }
   }
   ~RE2SearchImpl() {
-    delete re2_wrapper;
+    for (int i = 0; i < kMaxClones; i++) {
+      delete clones[i].wrapper.load();
+    }
+    delete atomSearch;
+  }
+
+  RE2Wrapper* Acquire() {
+    const int start = ThreadSlot();
+    for (int i = 0; i < kMaxClones; i++) {
+      RE2Wrapper* wrapper = clones[(start + i) % kMaxClones].wrapper.exchange(nullptr);
+      if (wrapper != nullptr)
+        return wrapper;
+    }
+
+    // The pattern has been compiled successfully by |StartSearchWorker|
+    // already.
+    RE2Wrapper* wrapper = new RE2Wrapper();
+    std::string error;
+    wrapper->Compile(pattern.data(), static_cast<int>(pattern.size()), caseSensitive, latin1, &error);
+    return wrapper;
   }
-  RE2Wrapper* re2_wrapper;
+
+  void Release(RE2Wrapper* wrapper) {
+    const int start = ThreadSlot();
+    for (int i = 0; i < kMaxClones; i++) {
+      RE2Wrapper* expected = nullptr;
+      if (clones[(start + i) % kMaxClones].wrapper.compare_exchange_strong(expected, wrapper))
+        return;
+    }
+    // More concurrent searches than slots.
+    delete wrapper;
+  }
+
+  // Deletes the clones in the pool beyond the first |maxClones|. Clones
+  // borrowed by searches in progress are returned to the pool as usual.
+  void TrimClones(int maxClones) {
+    int kept = 0;
+    for (int i = 0; i < kMaxClones; i++) {
+      if (clones[i].wrapper.load() == nullptr)
+        continue;
+      if (kept < maxClones) {
+        kept++;
+        continue;
+      }
+      delete clones[i].wrapper.exchange(nullptr);
+    }
+  }
+
+  static int ThreadSlot() {
+    return static_cast<int>(std::hash<std::thread::id>()(std::this_thread::get_id()) % kMaxClones);
+  }
+
+  // Copy of the pattern, which outlives the search that compiled it.
+  std::string pattern;
+  bool caseSensitive;
+  bool latin1;
+  CloneSlot clones[kMaxClones];
+  // The atoms searched before running RE2, see |RE2Search::GetPrefilterAtoms|.
+  std::string atoms;
+  AsciiSearchBase* atomSearch;
+  int atomBufferSize;
 };
 
-RE2Search::RE2Search()
-    : pattern_(NULL),
-      patternLen_(0),
-      impl_(new RE2SearchImpl()) {
+// Matches found by RE2 in one call, returned one at a time by
+// |FindNextWorker|. This is the layout of the start of the search buffer,
+// followed by the buffer of the atom search.
+struct RE2Search::MatchBatch {
+  // The text the offsets of |matches| are relative to.
+  const char* text;
+  int count;
+  int index;
+  RE2Wrapper::MatchPosition matches[kMaxBatchMatches];
+};
+
+RE2Search::RE2Search(CreateAtomSearchFunction createAtomSearch, Encoding encoding)
+    : createAtomSearch_(createAtomSearch),
+      encoding_(encoding) {
 }
 
 RE2Search::~RE2Search() {
-  delete impl_;
+  // |impl_| is null if the search could not be started.
+  if (impl_ != nullptr)
+    impl_->TrimClones(kMaxIdleClones);
+}
+
+const std::string& RE2Search::GetPrefilterAtoms() const {
+  return impl_->atoms;
 }
 
 void RE2Search::StartSearchWorker(
@@ -35,10 +174,22 @@ void RE2Search::StartSearchWorker(
     int patternLen,
     SearchOptions options,
     SearchCreateResult& result) {
+  // Whole word matching does not change the compiled regular expression.
+  const int compileOptions = (options & kMatchCase);
+  const CompiledPatternEngine engine = (encoding_ == kLatin1 ? kEngineRE2Latin1 : kEngineRE2);
+  impl_ = std::static_pointer_cast<RE2SearchImpl>(
+    FindCompiledPattern(engine, pattern, patternLen, compileOptions));
+  if (impl_ != nullptr) {
+    result.HResult = S_OK;
+    return;
+  }
+
+  impl_ = std::make_shared<RE2SearchImpl>();
   RE2Wrapper* re2_wrapper = new RE2Wrapper();
   bool caseSensitive = (options & kMatchCase);
+  bool latin1 = (encoding_ == kLatin1);
   std::string error;
-  re2_wrapper->Compile(pattern, patternLen, caseSensitive, &error);
+  re2_wrapper->Compile(pattern, patternLen, caseSensitive, latin1, &error);
   if (!error.empty()) {
     result.HResult = E_FAIL;
     strcpy_s(result.ErrorMessage, error.c_str());
@@ -46,35 +197,171 @@ void RE2Search::StartSearchWorker(
     return;
   }
 
-  impl_->re2_wrapper = re2_wrapper;
+  // RE2 starts on the line of the next atom, which would skip the start of
+  // matches spanning several lines.
+  if (!re2_wrapper->CanMatchNewline()) {
+    std::vector<std::string> atoms;
+    re2_wrapper->GetRequiredAtoms(kMinAtomLength, &atoms);
+    for (size_t i = 0; i < atoms.size(); i++) {
+      if (i > 0)
+        impl_->atoms += static_cast<char>(kAtomSeparator);
+      impl_->atoms += atoms[i];
+    }
+  }
+  if (!impl_->atoms.empty()) {
+    // RE2 runs on the whole text if the atoms cannot be searched.
+    SearchCreateResult atomResult;
+    impl_->atomSearch = createAtomSearch_(impl_->atoms.data(), static_cast<int>(impl_->atoms.size()), static_cast<SearchOptions>(0), &atomResult);
+    if (impl_->atomSearch != nullptr) {
+      impl_->atomBufferSize = impl_->atomSearch->GetSearchBufferSize();
+    } else {
+      impl_->atoms.clear();
+    }
+  }
+
+  impl_->pattern.assign(pattern, patternLen);
+  impl_->caseSensitive = caseSensitive;
+  impl_->latin1 = latin1;
+  impl_->Release(re2_wrapper);
+  AddCompiledPattern(engine, pattern, patternLen, compileOptions, impl_);
   result.HResult = S_OK;
 }
 
 int RE2Search::GetSearchBufferSize() {
-  return 0;
+  return sizeof(MatchBatch) + impl_->atomBufferSize;
 }
 
-void RE2Search::FindNextWorker(SearchParams* searchParams) {
-  const char* text;
-  int textLength;
-  if (searchParams->MatchStart == nullptr) {
-    text = searchParams->TextStart;
-    textLength = searchParams->TextLength;
+// Finds the next matches from |text| on, up to |kMaxBatchMatches|. |batch|
+// is left empty if there are no more matches or the search is cancelled.
+void RE2Search::FindMatches(SearchParams64* searchParams, const char* text, MatchBatch* batch) {
+  const char* textEnd = searchParams->TextStart + searchParams->TextLength;
+  batch->count = 0;
+  batch->index = 0;
+  RE2Wrapper* re2_wrapper = impl_->Acquire();
+  if (impl_->atomSearch == nullptr) {
+    FindMatchesInRange(searchParams, re2_wrapper, text, textEnd, batch);
   } else {
-    text = searchParams->MatchStart + searchParams->MatchLength;
-    // TODO (rpaquay): 2GB limit
-    textLength = static_cast<int>(searchParams->TextStart + searchParams->TextLength - text);
+    // Matches are inside a single line, which contains one of the atoms:
+    // the lines before the next atom are skipped.
+    while (batch->count == 0 && text <= textEnd && !IsCancelled(searchParams)) {
+      const char* atom = FindAtom(searchParams, text, textEnd);
+      if (atom == nullptr)
+        break;
+
+      const char* rangeStart = atom;
+      while (rangeStart > text && rangeStart[-1] != '\n')
+        rangeStart--;
+      const char* rangeEnd = atom + min(textEnd - atom, kMinAtomRangeLength);
+      rangeEnd = static_cast<const char*>(memchr(rangeEnd, '\n', textEnd - rangeEnd));
+      if (rangeEnd == nullptr)
+        rangeEnd = textEnd;
+      FindMatchesInRange(searchParams, re2_wrapper, rangeStart, rangeEnd, batch);
+      text = rangeEnd + 1;
+    }
+  }
+  impl_->Release(re2_wrapper);
+}
+
+// Finds the matches between |text| and |rangeEnd|, up to
+// |kMaxBatchMatches|.
+void RE2Search::FindMatchesInRange(
+    SearchParams64* searchParams,
+    RE2Wrapper* re2_wrapper,
+    const char* text,
+    const char* rangeEnd,
+    MatchBatch* batch) {
+  const char* textStart = searchParams->TextStart;
+  const char* textEnd = searchParams->TextStart + searchParams->TextLength;
+  const int64_t maxWindowLength =
+    searchParams->Cancelled != nullptr ? kCancellableWindowLength : kMaxWindowLength;
+  while (text <= rangeEnd && !IsCancelled(searchParams)) {
+    // The characters around the searched range tell RE2 whether the range
+    // starts or ends a line or a word.
+    const char* window = (text > textStart ? text - 1 : text);
+    int64_t remaining = rangeEnd - text;
+    int searchLength = static_cast<int>(min(remaining, maxWindowLength));
+    const char* searchEnd = text + searchLength;
+    const char* windowEnd = (searchEnd < textEnd ? searchEnd + 1 : searchEnd);
+    batch->text = window;
+    batch->count = re2_wrapper->MatchAll(
+      window,
+      static_cast<int>(windowEnd - window),
+      static_cast<int>(text - window),
+      static_cast<int>(searchEnd - window),
+      batch->matches,
+      kMaxBatchMatches);
+    if (searchLength == remaining)
+      break;
+    // Matches starting in the overlap may continue past the end of the
+    // window: search them again in the next window.
+    const int overlapStart = static_cast<int>(searchEnd - window - kWindowOverlap);
+    while (batch->count > 0 && batch->matches[batch->count - 1].Offset >= overlapStart)
+      batch->count--;
+    if (batch->count > 0)
+      break;
+    text = window + overlapStart;
+  }
+}
+
+// Returns the first atom between |text| and |textEnd|, or null if there is
+// none.
+const char* RE2Search::FindAtom(SearchParams64* searchParams, const char* text, const char* textEnd) {
+  SearchParams64 params;
+  memset(&params, 0, sizeof(params));
+  params.TextStart = text;
+  params.TextLength = textEnd - text;
+  params.SearchBuffer = reinterpret_cast<MatchBatch*>(searchParams->SearchBuffer) + 1;
+  impl_->atomSearch->FindNext(&params);
+  const char* result = params.MatchStart;
+  if (result != nullptr)
+    impl_->atomSearch->CancelSearch(&params);
+  return result;
+}
+
+void RE2Search::FindNextWorker(SearchParams64* searchParams) {
+  MatchBatch* batch = reinterpret_cast<MatchBatch*>(searchParams->SearchBuffer);
+  if (searchParams->MatchStart == nullptr) {
+    FindMatches(searchParams, searchParams->TextStart, batch);
+  } else if (batch->index == batch->count) {
+    FindMatches(searchParams, searchParams->MatchStart + searchParams->MatchLength, batch);
   }
 
-  const char* match;
-  int matchLength;
-  impl_->re2_wrapper->Match(text, textLength, &match, &matchLength);
-  if (matchLength == 0)
-    matchLength++;
-  searchParams->MatchStart = match;
-  searchParams->MatchLength = matchLength;
+  if (batch->index == batch->count) {
+    CancelSearch(searchParams);
+    return;
+  }
+
+  const RE2Wrapper::MatchPosition& match = batch->matches[batch->index++];
+  searchParams->MatchStart = batch->text + match.Offset;
+  // Empty matches are reported as one character, so that the next search
+  // starts after them.
+  searchParams->MatchLength = max(match.Length, 1);
+}
+
+int RE2Search::CountWorker(SearchParams64* searchParams, int maxCount) {
+  // The matches are counted one batch at a time, without leaving any state
+  // in the search buffer.
+  MatchBatch batch;
+  const char* text = searchParams->TextStart;
+  if (searchParams->MatchStart != nullptr)
+    text = searchParams->MatchStart + searchParams->MatchLength;
+  searchParams->MatchStart = nullptr;
+  searchParams->MatchLength = 0;
+
+  int count = 0;
+  while (count < maxCount) {
+    FindMatches(searchParams, text, &batch);
+    if (batch.count == 0)
+      break;
+    count += min(batch.count, maxCount - count);
+    const RE2Wrapper::MatchPosition& last = batch.matches[batch.count - 1];
+    text = batch.text + last.Offset + max(last.Length, 1);
+  }
+  return count;
 }
 
-void RE2Search::CancelSearch(SearchParams* searchParams) {
-  // Nothing to do, since out buffer is simple integers.
+void RE2Search::CancelSearch(SearchParams64* searchParams) {
+  // Nothing to release, the search buffer only holds offsets.
+  searchParams->MatchStart = nullptr;
+  searchParams->MatchLength = 0;
 }
@@ -4,24 +4,59 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include "search_base.h"
 
 class RE2SearchImpl;
+class RE2Wrapper;
 
+// Regular expression search with RE2.
+//
+// When the regular expression cannot match a newline, the literal strings
+// ("atoms") one of which is part of every match are extracted with
+// re2::Prefilter. The text is then searched for the atoms first, and RE2
+// only runs on the lines containing them.
 class RE2Search : public AsciiSearchBase {
  public:
-  RE2Search();
+  // Must match |MultiLiteralSearch::kPatternSeparator|.
+  enum { kAtomSeparator = '\n' };
+
+  typedef AsciiSearchBase* (*CreateAtomSearchFunction)(
+      const char* pattern,
+      int patternLen,
+      SearchOptions options,
+      SearchCreateResult* result);
+
+  // How RE2 reads the pattern and the text: UTF-8 characters, or bytes as
+  // std::regex does (see |RegexSearch|).
+  enum Encoding { kUtf8, kLatin1 };
+
+  // |createAtomSearch| is used to create the case insensitive search of the
+  // atoms, passed as a single string separated by |kAtomSeparator|.
+  RE2Search(CreateAtomSearchFunction createAtomSearch, Encoding encoding);
   virtual ~RE2Search() OVERRIDE;
 
   virtual int GetSearchBufferSize() OVERRIDE;
-  virtual void CancelSearch(SearchParams* searchParams) OVERRIDE;
+  virtual void CancelSearch(SearchParams64* searchParams) OVERRIDE;
+
+  // Returns the atoms searched before running RE2, separated by
+  // |kAtomSeparator|, or an empty string if RE2 runs on the whole text.
+  const std::string& GetPrefilterAtoms() const;
 
  protected:
   virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
-  virtual void FindNextWorker(SearchParams* searchParams) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+  virtual int CountWorker(SearchParams64* searchParams, int maxCount) OVERRIDE;
 
  private:
-  const char *pattern_;
-  int patternLen_;
-  RE2SearchImpl* impl_;
+  struct MatchBatch;
+  void FindMatches(SearchParams64* searchParams, const char* text, MatchBatch* batch);
+  void FindMatchesInRange(SearchParams64* searchParams, RE2Wrapper* re2_wrapper, const char* text, const char* rangeEnd, MatchBatch* batch);
+  const char* FindAtom(SearchParams64* searchParams, const char* text, const char* textEnd);
+
+  std::shared_ptr<RE2SearchImpl> impl_;
+  CreateAtomSearchFunction createAtomSearch_;
+  Encoding encoding_;
 };
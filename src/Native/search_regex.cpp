@@ -4,10 +4,14 @@
 
 #include "stdafx.h"
 
+#include <iterator>
 #include <regex>
 
 #include "search_regex.h"
 
+#include "compiled_pattern_cache.h"
+#include "regex_translation.h"
+
 
 class regex_traits_fast_icase : public std::regex_traits<char> {
 public:
@@ -18,15 +22,114 @@ public:
   }
 };
 
-#if 1
+namespace {
+
+// Thrown out of std::regex when |SearchParams64::Cancelled| is set.
+struct SearchCancelled {
+};
+
+// Shared by the copies of a |CancellableTextIterator|.
+struct CancellationCounter {
+  int stepsBeforeCheck;
+  const volatile int* cancelled;
+};
+
+// Iterator over the searched text, checking the cancellation flag every
+// |kCancellationCheckInterval| steps, as std::regex offers no other way of
+// stopping a search. |counter| is null if the search cannot be cancelled.
+class CancellableTextIterator {
+ public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef char value_type;
+  typedef ptrdiff_t difference_type;
+  typedef const char* pointer;
+  typedef const char& reference;
+
+  CancellableTextIterator() : current_(nullptr), counter_(nullptr) {
+  }
+  CancellableTextIterator(const char* current, CancellationCounter* counter)
+      : current_(current),
+        counter_(counter) {
+  }
+
+  const char* get() const { return current_; }
+
+  reference operator*() const { return *current_; }
+  pointer operator->() const { return current_; }
+  reference operator[](difference_type n) const { return current_[n]; }
+
+  CancellableTextIterator& operator++() {
+    ++current_;
+    Step();
+    return *this;
+  }
+  CancellableTextIterator operator++(int) {
+    CancellableTextIterator result = *this;
+    ++*this;
+    return result;
+  }
+  CancellableTextIterator& operator--() {
+    --current_;
+    Step();
+    return *this;
+  }
+  CancellableTextIterator operator--(int) {
+    CancellableTextIterator result = *this;
+    --*this;
+    return result;
+  }
+  CancellableTextIterator& operator+=(difference_type n) {
+    current_ += n;
+    return *this;
+  }
+  CancellableTextIterator& operator-=(difference_type n) {
+    current_ -= n;
+    return *this;
+  }
+  CancellableTextIterator operator+(difference_type n) const {
+    return CancellableTextIterator(current_ + n, counter_);
+  }
+  CancellableTextIterator operator-(difference_type n) const {
+    return CancellableTextIterator(current_ - n, counter_);
+  }
+  difference_type operator-(const CancellableTextIterator& other) const {
+    return current_ - other.current_;
+  }
+
+  bool operator==(const CancellableTextIterator& other) const { return current_ == other.current_; }
+  bool operator!=(const CancellableTextIterator& other) const { return current_ != other.current_; }
+  bool operator<(const CancellableTextIterator& other) const { return current_ < other.current_; }
+  bool operator>(const CancellableTextIterator& other) const { return current_ > other.current_; }
+  bool operator<=(const CancellableTextIterator& other) const { return current_ <= other.current_; }
+  bool operator>=(const CancellableTextIterator& other) const { return current_ >= other.current_; }
+
+ private:
+  void Step() {
+    if (counter_ == nullptr || --counter_->stepsBeforeCheck > 0)
+      return;
+    counter_->stepsBeforeCheck = AsciiSearchBase::kCancellationCheckInterval;
+    if (*counter_->cancelled != 0)
+      throw SearchCancelled();
+  }
+
+  const char* current_;
+  CancellationCounter* counter_;
+};
+
+}  // namespace
+
 typedef std::basic_regex<char, regex_traits_fast_icase> regex_t;
-typedef std::regex_iterator<const char *, char, regex_traits_fast_icase> regex_iterator_t;
-#else
-typedef std::regex regex_t;
-typedef std::cregex_iterator regex_iterator_t;
-#endif
+typedef std::regex_iterator<CancellableTextIterator, char, regex_traits_fast_icase> regex_iterator_t;
+
+// Layout of the search buffer.
+struct RegexSearchState {
+  regex_iterator_t it;
+  CancellationCounter counter;
+};
 
-class RegexSearchImpl {
+// The compiled regular expression, shared by the searches for the same
+// pattern through the compiled pattern cache.
+class RegexSearchImpl : public CompiledPattern {
 public:
   RegexSearchImpl() : regex_(nullptr) {
   }
@@ -37,14 +140,15 @@ public:
   regex_iterator_t it_end_;
 };
 
-RegexSearch::RegexSearch()
+RegexSearch::RegexSearch(RE2Search::CreateAtomSearchFunction createAtomSearch)
     : pattern_(NULL),
       patternLen_(0),
-      impl_(new RegexSearchImpl()) {
+      createAtomSearch_(createAtomSearch),
+      re2Search_(nullptr) {
 }
 
 RegexSearch::~RegexSearch() {
-  delete impl_;
+  delete re2Search_;
 }
 
 void RegexSearch::StartSearchWorker(
@@ -52,12 +156,42 @@ void RegexSearch::StartSearchWorker(
     int patternLen,
     SearchOptions options,
     SearchCreateResult& result) {
+  pattern_ = pattern;
+  patternLen_ = patternLen;
+
+  std::string re2Pattern;
+  if ((options & kNoRegexTranslation) == 0 &&
+      TranslateRegexToRE2(pattern, patternLen, (options & kMatchCase) != 0, &re2Pattern)) {
+    // Whole words are matched by this search, as with std::regex.
+    re2Search_ = new RE2Search(createAtomSearch_, RE2Search::kLatin1);
+    SearchCreateResult re2Result;
+    re2Search_->StartSearch(
+      re2Pattern.data(),
+      static_cast<int>(re2Pattern.size()),
+      static_cast<SearchOptions>(options & ~kMatchWholeWord),
+      re2Result);
+    if (SUCCEEDED(re2Result.HResult))
+      return;
+    // E.g. repeat counts over the limit of RE2.
+    delete re2Search_;
+    re2Search_ = nullptr;
+  }
+
+  // Whole word matching does not change the compiled regular expression.
+  const int compileOptions = (options & kMatchCase);
+  impl_ = std::static_pointer_cast<RegexSearchImpl>(
+    FindCompiledPattern(kEngineStdRegex, pattern, patternLen, compileOptions));
+  if (impl_ != nullptr)
+    return;
+
   auto flags = std::regex::ECMAScript /*| std::regex::optimize*/;
   if ((options & kMatchCase) == 0) {
     flags = flags | std::regex::icase;
   }
+  impl_ = std::make_shared<RegexSearchImpl>();
   try {
     impl_->regex_ = new regex_t(pattern, patternLen, flags);
+    AddCompiledPattern(kEngineStdRegex, pattern, patternLen, compileOptions, impl_);
   } catch(std::regex_error& error) {
     result.HResult = E_INVALIDARG;
     // Format the error message: remove the leading text up to ':'
@@ -71,41 +205,69 @@ void RegexSearch::StartSearchWorker(
     }
     strcpy_s(result.ErrorMessage, errorMessage.c_str());
   }
-  pattern_ = pattern;
-  patternLen_ = patternLen;
 }
 
 int RegexSearch::GetSearchBufferSize() {
-  return sizeof(std::cregex_iterator);
+  if (re2Search_ != nullptr)
+    return re2Search_->GetSearchBufferSize();
+  return sizeof(RegexSearchState);
 }
 
-void RegexSearch::FindNextWorker(SearchParams* searchParams) {
-  regex_iterator_t* pit =
-      reinterpret_cast<regex_iterator_t*>(searchParams->SearchBuffer);
-  // Placement new for the iterator on the 1st call
-  if (searchParams->MatchStart == nullptr) {
-    pit = new(pit) regex_iterator_t(
-        searchParams->TextStart,
-        searchParams->TextStart + searchParams->TextLength,
-        *impl_->regex_);
-  }
-  // Iterate
-  regex_iterator_t& it(*pit);
-  if (it == impl_->it_end_) {
-    // Implicit cleanup on completed search.
-    CancelSearch(searchParams);
+void RegexSearch::FindNextWorker(SearchParams64* searchParams) {
+  if (re2Search_ != nullptr) {
+    re2Search_->FindNext(searchParams);
     return;
   }
-  // Set result if match found
-  searchParams->MatchStart = searchParams->TextStart + it->position();
-  searchParams->MatchLength = (int)it->length(); // TODO(rpaquay): 2GB limit
-  ++it;
+
+  RegexSearchState* state =
+      reinterpret_cast<RegexSearchState*>(searchParams->SearchBuffer);
+  try {
+    // Placement new for the iterator on the 1st call. The iterator searches
+    // the first match as soon as it is constructed, so it is assigned
+    // after construction, to be destructible if the search is cancelled.
+    if (searchParams->MatchStart == nullptr) {
+      state->counter.stepsBeforeCheck = kCancellationCheckInterval;
+      state->counter.cancelled = searchParams->Cancelled;
+      CancellationCounter* counter =
+          searchParams->Cancelled != nullptr ? &state->counter : nullptr;
+      new(&state->it) regex_iterator_t();
+      state->it = regex_iterator_t(
+          CancellableTextIterator(searchParams->TextStart, counter),
+          CancellableTextIterator(searchParams->TextStart + searchParams->TextLength, counter),
+          *impl_->regex_);
+    }
+    // Iterate
+    regex_iterator_t& it(state->it);
+    if (it == impl_->it_end_) {
+      // Implicit cleanup on completed search.
+      CancelSearch(searchParams);
+      return;
+    }
+    // Set result if match found
+    searchParams->MatchStart = searchParams->TextStart + it->position();
+    searchParams->MatchLength = it->length();
+    ++it;
+  } catch (SearchCancelled&) {
+    CancelSearch(searchParams);
+  }
+}
+
+int RegexSearch::CountWorker(SearchParams64* searchParams, int maxCount) {
+  if (re2Search_ != nullptr)
+    return re2Search_->Count(searchParams, maxCount);
+  return AsciiSearchBase::CountWorker(searchParams, maxCount);
 }
 
-void RegexSearch::CancelSearch(SearchParams* searchParams) {
-  regex_iterator_t* pit =
-      reinterpret_cast<regex_iterator_t*>(searchParams->SearchBuffer);
+void RegexSearch::CancelSearch(SearchParams64* searchParams) {
+  if (re2Search_ != nullptr) {
+    re2Search_->CancelSearch(searchParams);
+    return;
+  }
+
+  RegexSearchState* state =
+      reinterpret_cast<RegexSearchState*>(searchParams->SearchBuffer);
   // Explicit destructor call to match placement new call.
-  pit->regex_iterator_t::~regex_iterator_t();
+  state->it.regex_iterator_t::~regex_iterator_t();
   searchParams->MatchStart = nullptr;
+  searchParams->MatchLength = 0;
 }
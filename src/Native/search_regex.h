@@ -4,24 +4,45 @@
 
 #pragma once
 
+#include <memory>
+
 #include "search_base.h"
+#include "search_re2.h"
 
 class RegexSearchImpl;
 
+// Regular expression search with the ECMAScript grammar of std::regex.
+//
+// std::regex backtracks, which makes it much slower than RE2 on large texts
+// and exponentially slow on some patterns. The patterns RE2 matches the same
+// way (see regex_translation.h) are searched with RE2 instead, and
+// std::regex only runs the others, e.g. patterns with backreferences, or
+// all of them with |kNoRegexTranslation|.
 class RegexSearch : public AsciiSearchBase {
  public:
-  RegexSearch();
+  enum Engine { kStdRegex, kRE2 };
+
+  // |createAtomSearch| is passed to the |RE2Search| of the patterns searched
+  // with RE2.
+  explicit RegexSearch(RE2Search::CreateAtomSearchFunction createAtomSearch);
   virtual ~RegexSearch() OVERRIDE;
 
   virtual int GetSearchBufferSize() OVERRIDE;
-  virtual void CancelSearch(SearchParams* searchParams) OVERRIDE;
+  virtual void CancelSearch(SearchParams64* searchParams) OVERRIDE;
+
+  // Returns the engine the pattern is searched with.
+  Engine GetEngine() const { return re2Search_ != nullptr ? kRE2 : kStdRegex; }
 
  protected:
   virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
-  virtual void FindNextWorker(SearchParams* searchParams) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+  virtual int CountWorker(SearchParams64* searchParams, int maxCount) OVERRIDE;
 
  private:
   const char *pattern_;
   int patternLen_;
-  RegexSearchImpl* impl_;
+  std::shared_ptr<RegexSearchImpl> impl_;
+  RE2Search::CreateAtomSearchFunction createAtomSearch_;
+  // Not null if the pattern is searched with RE2.
+  RE2Search* re2Search_;
 };
@@ -0,0 +1,281 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <intrin.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "byte_frequency.h"
+#include "search_base.h"
+#include "simd_vector.h"
+
+template <typename T>
+struct SimdLiteralCompare {
+};
+
+template <>
+struct SimdLiteralCompare<CaseSensitive> {
+  template <typename V>
+  static typename V::Type Equal(typename V::Type block, typename V::Type value, typename V::Type valueAlt) {
+    return V::CmpEq(block, value);
+  }
+};
+
+template <>
+struct SimdLiteralCompare<CaseInsensitive> {
+  // |value| is the lower case version of the pattern byte, |valueAlt| the
+  // upper case version (identical for non letters).
+  template <typename V>
+  static typename V::Type Equal(typename V::Type block, typename V::Type value, typename V::Type valueAlt) {
+    return V::Or(V::CmpEq(block, value), V::CmpEq(block, valueAlt));
+  }
+};
+
+// Literal search using packed compares. For each block of 16 (SSE2) or 32
+// (AVX2) text positions, two bytes of the pattern are compared against the
+// text at once, and only the positions where both bytes match are verified
+// byte by byte. The two bytes are the least frequent ones of the pattern (see
+// byte_frequency.h), so that patterns ending with a common character (e.g.
+// "ptr->") produce few candidates.
+//
+// When matching whole words, word boundaries are checked with the same
+// packed compares, so that the occurrences of short identifiers inside
+// longer words (e.g. "id" in "width") are not even verified.
+//
+// See http://0x80.pl/articles/simd-strfind.html ("Generic SIMD").
+template<typename T, typename W = AnyWord, typename V = Sse2Vector>
+class SimdLiteralSearch : public AsciiSearchBaseTemplate<T, W> {
+ public:
+  SimdLiteralSearch()
+      : pattern_(NULL),
+        patternLen_(0),
+        anchor1_(0),
+        anchor2_(0),
+        offset1_(0),
+        offset2_(0),
+        wordPattern_(false) {
+  }
+
+  void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE {
+    pattern_ = pattern;
+    patternLen_ = patternLen;
+    if (patternLen > 0) {
+      const uint8_t *pat = (const uint8_t*)pattern;
+      GetRarestByteOffsets(pat, patternLen, (options & kMatchCase) != 0, &offset1_, &offset2_);
+      anchor1_ = Traits::FetchByte(pat, offset1_);
+      anchor2_ = Traits::FetchByte(pat, offset2_);
+    }
+
+    // Candidates can be rejected on word boundaries before verification
+    // only if the pattern is made of word characters: a match that is not a
+    // whole word then never hides a whole word match overlapping it.
+    wordPattern_ = true;
+    for (int i = 0; i < patternLen; i++) {
+      if (!IsWordCharacter(pattern[i])) {
+        wordPattern_ = false;
+        break;
+      }
+    }
+  }
+
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
+    const char* text = searchParams->TextStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = searchParams->MatchStart + searchParams->MatchLength;
+      textLen = searchParams->TextStart + searchParams->TextLength - text;
+    }
+
+    searchParams->MatchStart = simd_literal_algo(text, textLen, searchParams->TextStart);
+
+    if (searchParams->MatchStart != nullptr) {
+      searchParams->MatchLength = patternLen_;
+    }
+  }
+
+  virtual int CountWorker(SearchParams64* searchParams, int maxCount) OVERRIDE {
+    const char* text = searchParams->TextStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = searchParams->MatchStart + searchParams->MatchLength;
+      textLen = searchParams->TextStart + searchParams->TextLength - text;
+    }
+
+    searchParams->MatchStart = nullptr;
+    return simd_literal_count(text, textLen, searchParams->TextStart, maxCount);
+  }
+
+ private:
+  static uint8_t ToUpper(uint8_t value) {
+    return (value >= 'a' && value <= 'z') ? (value & ~0x20) : value;
+  }
+
+  static bool Verify(const uint8_t* text, const uint8_t* pattern, int patternLen) {
+    for (int j = 0; j < patternLen; j++) {
+      if (Traits::FetchByte(text, j) != Traits::FetchByte(pattern, j))
+        return false;
+    }
+    return true;
+  }
+
+  // Returns the mask of the bytes of |block| that are word characters, see
+  // |IsWordCharacter|.
+  static typename V::Type WordCharacters(typename V::Type block) {
+    // Bytes >= 0x80 are negative in signed comparisons, i.e. not in range.
+    typename V::Type lower = V::Or(block, V::Set1(0x20));
+    typename V::Type letter = V::And(V::CmpGt(lower, V::Set1('a' - 1)),
+                                     V::CmpGt(V::Set1('z' + 1), lower));
+    typename V::Type digit = V::And(V::CmpGt(block, V::Set1('0' - 1)),
+                                    V::CmpGt(V::Set1('9' + 1), block));
+    return V::Or(V::Or(letter, digit), V::CmpEq(block, V::Set1('_')));
+  }
+
+  // Returns the mask of the positions of the block at |tgt + i| where a whole
+  // word match of the pattern may start. All positions are returned if the
+  // bytes around the block are not all inside the text, as the candidates
+  // are checked again after verification anyway.
+  uint32_t WordBoundaryMask(const uint8_t* tgt, int64_t i, int64_t textLen, const char* textStart) const {
+    if (!wordPattern_ || (i == 0 && (const char*)tgt == textStart) ||
+        i + patternLen_ + V::kSize > textLen) {
+      return ~0u;
+    }
+    typename V::Type before = WordCharacters(V::Load(tgt + i - 1));
+    typename V::Type after = WordCharacters(V::Load(tgt + i + patternLen_));
+    return ~V::MoveMask(V::Or(before, after));
+  }
+
+  // Returns the first match in |text|, which ends the searched text starting
+  // at |textStart|. When matching whole words, the search resumes after the
+  // end of the matches that are not whole words, as |FindNextWholeWord|
+  // would.
+  const char *simd_literal_algo(const char *text, int64_t textLen, const char* textStart) const {
+    const int patternLen = patternLen_;
+    if (patternLen <= 0 || textLen < patternLen)
+      return NULL;
+
+    const uint8_t *tgt = (const uint8_t*)text;
+    const uint8_t *pat = (const uint8_t*)pattern_;
+    const char* textEnd = text + textLen;
+    const typename V::Type vanchor1 = V::Set1(anchor1_);
+    const typename V::Type vanchor1Alt = V::Set1(ToUpper(anchor1_));
+    const typename V::Type vanchor2 = V::Set1(anchor2_);
+    const typename V::Type vanchor2Alt = V::Set1(ToUpper(anchor2_));
+
+    // Process blocks of positions as long as the blocks compared with the
+    // anchor bytes fit entirely inside the text (both offsets are less than
+    // |patternLen|).
+    const char* result = NULL;
+    // The first position a match can start at.
+    int64_t next = 0;
+    int64_t i = 0;
+    const int64_t blockLimit = textLen - patternLen - (V::kSize - 1);
+    for (; i <= blockLimit && result == NULL; i += V::kSize) {
+      typename V::Type block1 = V::Load(tgt + i + offset1_);
+      typename V::Type block2 = V::Load(tgt + i + offset2_);
+      typename V::Type eq = V::And(
+        SimdLiteralCompare<T>::template Equal<V>(block1, vanchor1, vanchor1Alt),
+        SimdLiteralCompare<T>::template Equal<V>(block2, vanchor2, vanchor2Alt));
+      unsigned long mask = V::MoveMask(eq);
+      if (WordTraits::kWholeWord && mask)
+        mask &= WordBoundaryMask(tgt, i, textLen, textStart);
+      while (mask) {
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        mask &= mask - 1;
+        int64_t position = i + bit;
+        if (position < next || !Verify(tgt + position, pat, patternLen))
+          continue;
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + position, patternLen)) {
+          result = text + position;
+          break;
+        }
+        next = position + patternLen;
+      }
+    }
+    V::Leave();
+    if (result != NULL)
+      return result;
+
+    // Remaining positions (less than one block)
+    for (i = max(i, next); i <= textLen - patternLen; i++) {
+      if (Verify(tgt + i, pat, patternLen)) {
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + i, patternLen))
+          return text + i;
+        i += patternLen - 1;
+      }
+    }
+
+    return NULL;
+  }
+
+  // Same as |simd_literal_algo|, except matches are counted (up to
+  // |maxCount|) without leaving the loop. Candidates overlapping the previous
+  // match are skipped, as |FindNext| would.
+  int simd_literal_count(const char *text, int64_t textLen, const char* textStart, int maxCount) const {
+    const int patternLen = patternLen_;
+    if (patternLen <= 0 || textLen < patternLen || maxCount <= 0)
+      return 0;
+
+    const uint8_t *tgt = (const uint8_t*)text;
+    const uint8_t *pat = (const uint8_t*)pattern_;
+    const char* textEnd = text + textLen;
+    const typename V::Type vanchor1 = V::Set1(anchor1_);
+    const typename V::Type vanchor1Alt = V::Set1(ToUpper(anchor1_));
+    const typename V::Type vanchor2 = V::Set1(anchor2_);
+    const typename V::Type vanchor2Alt = V::Set1(ToUpper(anchor2_));
+
+    int count = 0;
+    // The first position a match can start at.
+    int64_t next = 0;
+    int64_t i = 0;
+    const int64_t blockLimit = textLen - patternLen - (V::kSize - 1);
+    for (; i <= blockLimit && count < maxCount; i += V::kSize) {
+      typename V::Type block1 = V::Load(tgt + i + offset1_);
+      typename V::Type block2 = V::Load(tgt + i + offset2_);
+      typename V::Type eq = V::And(
+        SimdLiteralCompare<T>::template Equal<V>(block1, vanchor1, vanchor1Alt),
+        SimdLiteralCompare<T>::template Equal<V>(block2, vanchor2, vanchor2Alt));
+      unsigned long mask = V::MoveMask(eq);
+      if (WordTraits::kWholeWord && mask)
+        mask &= WordBoundaryMask(tgt, i, textLen, textStart);
+      while (mask) {
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        mask &= mask - 1;
+        int64_t position = i + bit;
+        if (position < next || !Verify(tgt + position, pat, patternLen))
+          continue;
+        next = position + patternLen;
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + position, patternLen)) {
+          if (++count == maxCount)
+            break;
+        }
+      }
+    }
+    V::Leave();
+
+    // Remaining positions (less than one block)
+    for (i = max(i, next); i <= textLen - patternLen && count < maxCount; i++) {
+      if (Verify(tgt + i, pat, patternLen)) {
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + i, patternLen))
+          count++;
+        i += patternLen - 1;
+      }
+    }
+
+    return count;
+  }
+
+  const char *pattern_;
+  int patternLen_;
+  uint8_t anchor1_;
+  uint8_t anchor2_;
+  int offset1_;
+  int offset2_;
+  // True if the pattern is made of word characters only.
+  bool wordPattern_;
+};
@@ -0,0 +1,123 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "search_streaming.h"
+
+#include <assert.h>
+
+StreamingSearch::StreamingSearch(
+    AsciiSearchBase* search,
+    AsciiSearchBase::SearchOptions options,
+    int64_t maxMatchLength)
+    : search_(search),
+      matchWholeWord_((options & AsciiSearchBase::kMatchWholeWord) != 0),
+      maxMatchLength_(max(maxMatchLength, int64_t(1))),
+      contextLength_(search->GetContextLength()),
+      lookaheadLength_(maxMatchLength_ + 2 * contextLength_),
+      searchBuffer_(search->GetSearchBufferSize()),
+      bufferOffset_(0),
+      searchStart_(0),
+      matchEnd_(0),
+      fetchedCount_(0) {
+}
+
+int StreamingSearch::FeedChunk(const char* chunk, int64_t chunkLength) {
+  buffer_.insert(buffer_.end(), chunk, chunk + chunkLength);
+  SearchBuffer(false);
+  return static_cast<int>(matches_.size() - fetchedCount_);
+}
+
+int StreamingSearch::Finish() {
+  SearchBuffer(true);
+  buffer_.clear();
+  bufferOffset_ = 0;
+  searchStart_ = 0;
+  matchEnd_ = 0;
+  return static_cast<int>(matches_.size() - fetchedCount_);
+}
+
+int StreamingSearch::FetchMatches(AsciiSearchBase::SearchMatch64* matches, int capacity) {
+  int count = static_cast<int>(min(matches_.size() - fetchedCount_, static_cast<size_t>(max(capacity, 0))));
+  for (int i = 0; i < count; i++) {
+    matches[i] = matches_[fetchedCount_ + i];
+  }
+  fetchedCount_ += count;
+  if (fetchedCount_ == matches_.size()) {
+    matches_.clear();
+    fetchedCount_ = 0;
+  }
+  return count;
+}
+
+void StreamingSearch::SearchBuffer(bool endOfText) {
+  const char* buffer = buffer_.data();
+  const int64_t bufferLength = buffer_.size();
+
+  // Unless the end of the text is reached, the search stops where the
+  // candidates starting before the last |lookaheadLength_| characters end,
+  // so that whether the candidates it goes through match does not depend on
+  // the next chunk.
+  int64_t searchEnd = bufferLength;
+  if (!endOfText)
+    searchEnd = max(bufferLength - lookaheadLength_ + maxMatchLength_, searchStart_);
+
+  AsciiSearchBase::SearchParams64 params = AsciiSearchBase::SearchParams64();
+  params.TextStart = buffer + searchStart_;
+  params.TextLength = searchEnd - searchStart_;
+  params.SearchBuffer = searchBuffer_.data();
+  params.ContextStart = buffer + matchEnd_;
+  params.ContextLength = bufferLength - matchEnd_;
+
+  // The end of the last candidate match the search went through before the
+  // current one (see |AsciiSearchBase::GetCandidateEnd|): searching again
+  // from there finds the same matches as searching the whole text.
+  int64_t candidateEnd = searchStart_;
+  while (true) {
+    search_->FindNext(&params);
+    const char* searchCandidateEnd = search_->GetCandidateEnd(&params);
+    if (searchCandidateEnd != nullptr)
+      candidateEnd = searchCandidateEnd - buffer;
+    if (params.MatchStart == nullptr)
+      break;
+
+    int64_t matchStart = params.MatchStart - buffer;
+    if (!endOfText && matchStart + lookaheadLength_ >= bufferLength) {
+      // The next chunk may change this match: search again once the next
+      // chunk is fed.
+      search_->CancelSearch(&params);
+      break;
+    }
+
+    // Matches that are not whole words are skipped here instead of inside
+    // the search, so that the search resumes after them, as when searching
+    // the whole text.
+    candidateEnd = matchStart + params.MatchLength;
+    if (matchWholeWord_ &&
+        !AsciiSearchBase::IsWholeWordMatch(buffer, buffer + bufferLength, params.MatchStart, params.MatchLength)) {
+      continue;
+    }
+    AsciiSearchBase::SearchMatch64 match = { bufferOffset_ + matchStart, params.MatchLength };
+    matches_.push_back(match);
+    matchEnd_ = matchStart + params.MatchLength;
+  }
+
+  if (endOfText)
+    return;
+
+  // All the matches starting before the last |lookaheadLength_| characters
+  // have been reported, and the search finds the same matches when resumed
+  // anywhere between |candidateEnd| and the next candidate, which starts
+  // after them.
+  int64_t resumeStart = max(candidateEnd, bufferLength - lookaheadLength_);
+  assert(resumeStart >= searchStart_);
+
+  // Keep the text from |resumeStart|, with the context before it.
+  int64_t keepStart = max(resumeStart - max(int64_t(kContextLength), contextLength_), int64_t(0));
+  buffer_.erase(buffer_.begin(), buffer_.begin() + keepStart);
+  bufferOffset_ += keepStart;
+  searchStart_ = resumeStart - keepStart;
+  matchEnd_ = max(matchEnd_ - keepStart, int64_t(0));
+}
@@ -0,0 +1,95 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <vector>
+
+#include "search_base.h"
+
+// Searches a text fed one chunk at a time, e.g. a large file read or mapped
+// one window at a time, with any search algorithm. The matches are the same
+// as if the whole text was searched at once, as long as they are not longer
+// than |maxMatchLength|, not counting the characters an algorithm finds
+// around a match in the context of the searched text (see
+// |AsciiSearchBase::GetContextLength|).
+//
+// The end of each chunk is kept until the next chunk is fed, together with
+// the text before it that whole word matching and the algorithm look at
+// (see |kContextLength|), so that matches spanning chunk boundaries are
+// found the same way as when searching the whole text. A match is reported
+// only once the text following it is long enough that no further chunk can
+// change it (e.g. extend a regular expression match, make a match fail
+// whole word matching, or extend the line a wildcard match is found on).
+// The search of the next chunk resumes after the last candidate match the
+// algorithm went through, including the ones it rejected (see
+// |AsciiSearchBase::GetCandidateEnd|), since restarting inside a rejected
+// candidate may find matches the search of the whole text skips. For the
+// same reason, whole word matching is checked here instead of inside the
+// algorithm.
+//
+// For instance, the entries of a wildcard search are searched on lines of
+// up to |WildcardSearch::kMaxLineExtentOffset| characters around its
+// longest entry, so that its matches may be much longer than its pattern:
+// they are found as long as |maxMatchLength| is the length of the longest
+// entry.
+//
+// Approximate searches (see |ApproximateSearch|) may report slightly
+// different matches, as their matches depend on where the search starts.
+class StreamingSearch {
+ public:
+  // Minimum length of the text kept before the position the next search
+  // starts at. Algorithms with a larger |AsciiSearchBase::GetContextLength|
+  // get more.
+  enum { kContextLength = 1024 };
+
+  // |search| must outlive this instance. |options| must be the options
+  // |search| was started with, except for |kMatchWholeWord|: |search| must
+  // not match whole words, and |options| has |kMatchWholeWord| to report
+  // whole word matches only. Wildcard searches (|WildcardSearch|) match
+  // whole words in their entries instead, with |kMatchWholeWord| in the
+  // options of |search| only.
+  StreamingSearch(
+      AsciiSearchBase* search,
+      AsciiSearchBase::SearchOptions options,
+      int64_t maxMatchLength);
+
+  // Searches |chunk|, which follows the chunks fed so far. Returns the
+  // number of matches ready to be fetched with |FetchMatches|. |chunk| does
+  // not need to outlive the call.
+  int FeedChunk(const char* chunk, int64_t chunkLength);
+  // Searches the end of the text kept from the last chunk. Returns the
+  // number of matches ready to be fetched with |FetchMatches|. The next
+  // chunk fed starts a new text.
+  int Finish();
+  // Stores up to |capacity| of the matches found so far in |matches|, with
+  // offsets relative to the start of the text, and returns the number of
+  // matches stored. The matches stored are not returned again.
+  int FetchMatches(AsciiSearchBase::SearchMatch64* matches, int capacity);
+
+ private:
+  void SearchBuffer(bool endOfText);
+
+  AsciiSearchBase* search_;
+  bool matchWholeWord_;
+  int64_t maxMatchLength_;
+  // See |AsciiSearchBase::GetContextLength|.
+  int64_t contextLength_;
+  // The length of the text after the start of a match that may change it:
+  // |maxMatchLength_|, and the context the algorithm looks at before and
+  // after it.
+  int64_t lookaheadLength_;
+  std::vector<char> searchBuffer_;
+  // The end of the text fed so far, starting at |bufferOffset_| in the
+  // whole text.
+  std::vector<char> buffer_;
+  int64_t bufferOffset_;
+  // The position in |buffer_| the next search starts at.
+  int64_t searchStart_;
+  // The end of the last match reported in |buffer_|, or 0. The algorithm
+  // does not see the context before it, as when searching the whole text.
+  int64_t matchEnd_;
+  std::vector<AsciiSearchBase::SearchMatch64> matches_;
+  size_t fetchedCount_;
+};
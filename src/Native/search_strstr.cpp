@@ -22,7 +22,7 @@ void StrStrSearch::StartSearchWorker(
   patternLen_ = patternLen;
 }
 
-void StrStrSearch::FindNextWorker(SearchParams* searchParams) {
+void StrStrSearch::FindNextWorker(SearchParams64* searchParams) {
   const char* start = searchParams->TextStart;
   const char* last = searchParams->TextStart + searchParams->TextLength;
   if (searchParams->MatchStart) {
@@ -12,7 +12,7 @@ class StrStrSearch : public AsciiSearchBase {
 
  protected:
   virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
-  virtual void FindNextWorker(SearchParams* searchParams) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
 
  private:
   const char *pattern_;
@@ -0,0 +1,85 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "search_strstr_sse42.h"
+
+#include <nmmintrin.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+
+const int kBlockSize = 16;
+const int kEqualOrdered = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED;
+
+const char* strstr_sse42_algo(const char* start, const char* last,
+                              const char* pattern, int patternLen) {
+  if (patternLen <= 0)
+    return last;
+
+  // "pcmpestri" looks for (a prefix of) the first 16 bytes of the pattern,
+  // candidates are then verified with a regular compare.
+  const int needleLen = min(patternLen, kBlockSize);
+  char needleBytes[kBlockSize] = { 0 };
+  memcpy(needleBytes, pattern, needleLen);
+  const __m128i needle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(needleBytes));
+
+  // Only load full 16 byte blocks inside the text.
+  const char* current = start;
+  while (last - current >= kBlockSize) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    int index = _mm_cmpestri(needle, needleLen, block, kBlockSize, kEqualOrdered);
+    if (index == kBlockSize) {
+      current += kBlockSize;
+      continue;
+    }
+
+    // |index| is the first position of a full match or of a partial match
+    // running past the end of the block.
+    const char* candidate = current + index;
+    if (last - candidate < patternLen)
+      return last;
+    if (memcmp(candidate, pattern, patternLen) == 0)
+      return candidate;
+    current = candidate + 1;
+  }
+
+  return std::search(current, last, pattern, pattern + patternLen);
+}
+
+}  // namespace
+
+StrStrSse42Search::StrStrSse42Search()
+    : pattern_(NULL),
+      patternLen_(0) {
+}
+
+void StrStrSse42Search::StartSearchWorker(
+    const char *pattern,
+    int patternLen,
+    SearchOptions options,
+    SearchCreateResult& result) {
+  pattern_ = pattern;
+  patternLen_ = patternLen;
+}
+
+void StrStrSse42Search::FindNextWorker(SearchParams64* searchParams) {
+  const char* start = searchParams->TextStart;
+  const char* last = searchParams->TextStart + searchParams->TextLength;
+  if (searchParams->MatchStart) {
+    start = searchParams->MatchStart + searchParams->MatchLength;
+  }
+
+  auto result = strstr_sse42_algo(start, last, pattern_, patternLen_);
+  if (result == last) {
+    searchParams->MatchStart = nullptr;
+    searchParams->MatchLength = 0;
+    return;
+  }
+  searchParams->MatchStart = result;
+  searchParams->MatchLength = patternLen_;
+}
@@ -0,0 +1,24 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include "search_base.h"
+
+// Variant of |StrStrSearch| using the SSE4.2 "pcmpestri" string instruction
+// to locate candidate positions 16 bytes at a time.
+//
+// Note: Must only be used if |GetCpuFeatures()| reports |kCpuFeatureSse42|.
+class StrStrSse42Search : public AsciiSearchBase {
+ public:
+  StrStrSse42Search();
+
+ protected:
+  virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+
+ private:
+  const char *pattern_;
+  int patternLen_;
+};
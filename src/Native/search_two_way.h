@@ -0,0 +1,183 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "search_base.h"
+
+// Two-Way string matching (Crochemore-Perrin). The pattern is split at a
+// critical factorization into a left and a right part: the right part is
+// compared left to right, then the left part right to left. The search runs
+// in linear time and constant memory whatever the pattern and the text, which
+// makes it the algorithm of choice for periodic patterns (e.g. "========")
+// on repetitive text, where algorithms verifying each candidate position
+// independently are quadratic.
+//
+// See http://www-igm.univ-mlv.fr/~lecroq/string/node26.html
+template<typename T, typename W = AnyWord>
+class TwoWaySearch : public AsciiSearchBaseTemplate<T, W> {
+ public:
+  TwoWaySearch()
+      : pattern_(NULL),
+        patternLen_(0),
+        ell_(0),
+        period_(0),
+        periodic_(false) {
+  }
+
+  void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE {
+    pattern_ = pattern;
+    patternLen_ = patternLen;
+    if (patternLen <= 0)
+      return;
+
+    const uint8_t* pat = (const uint8_t*)pattern;
+    int period1;
+    int period2;
+    int ms1 = MaximalSuffix(pat, patternLen, false, &period1);
+    int ms2 = MaximalSuffix(pat, patternLen, true, &period2);
+    if (ms1 > ms2) {
+      ell_ = ms1;
+      period_ = period1;
+    } else {
+      ell_ = ms2;
+      period_ = period2;
+    }
+
+    // The pattern is periodic if the left part is a suffix of the first
+    // period (i.e. x[0..ell] == x[period..period+ell]).
+    periodic_ = true;
+    for (int i = 0; i <= ell_; i++) {
+      if (Traits::FetchByte(pat, i) != Traits::FetchByte(pat, i + period_)) {
+        periodic_ = false;
+        break;
+      }
+    }
+    if (!periodic_) {
+      period_ = max(ell_ + 1, patternLen - ell_ - 1) + 1;
+    }
+  }
+
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
+    const char* text = searchParams->TextStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = searchParams->MatchStart + searchParams->MatchLength;
+      textLen = searchParams->TextStart + searchParams->TextLength - text;
+    }
+
+    searchParams->MatchStart = two_way_algo(text, textLen, searchParams->TextStart);
+
+    if (searchParams->MatchStart != nullptr) {
+      searchParams->MatchLength = patternLen_;
+    }
+  }
+
+ private:
+  // Returns the starting position (minus one) of the maximal suffix of
+  // |pattern| for the byte order (or the reversed byte order if |reversed|
+  // is true), and the period of that suffix in |period|.
+  static int MaximalSuffix(const uint8_t* pattern, int patternLen, bool reversed, int* period) {
+    int ms = -1;
+    int j = 0;
+    int k = 1;
+    int p = 1;
+    while (j + k < patternLen) {
+      uint8_t a = Traits::FetchByte(pattern, j + k);
+      uint8_t b = Traits::FetchByte(pattern, ms + k);
+      if (reversed ? (a > b) : (a < b)) {
+        j += k;
+        k = 1;
+        p = j - ms;
+      } else if (a == b) {
+        if (k != p) {
+          ++k;
+        } else {
+          j += p;
+          k = 1;
+        }
+      } else {
+        ms = j;
+        j = ms + 1;
+        k = p = 1;
+      }
+    }
+    *period = p;
+    return ms;
+  }
+
+  const char *two_way_algo(const char *text, int64_t textLen, const char* textStart) const {
+    const int m = patternLen_;
+    if (m <= 0 || textLen < m)
+      return NULL;
+
+    const uint8_t* x = (const uint8_t*)pattern_;
+    const uint8_t* y = (const uint8_t*)text;
+    const int ell = ell_;
+    const int period = period_;
+
+    if (periodic_) {
+      // Number of bytes of the left part known to match after a shift by
+      // |period|.
+      int memory = -1;
+      for (int64_t j = 0; j <= textLen - m;) {
+        int i = max(ell, memory) + 1;
+        while (i < m && Traits::FetchByte(x, i) == Traits::FetchByte(y, i + j))
+          ++i;
+        if (i >= m) {
+          i = ell;
+          while (i > memory && Traits::FetchByte(x, i) == Traits::FetchByte(y, i + j))
+            --i;
+          if (i <= memory) {
+            if (WordTraits::IsWordMatch(textStart, text + textLen, text + j, m))
+              return text + j;
+            // Skip the match, as |FindNextWholeWord| would.
+            j += m;
+            memory = -1;
+            continue;
+          }
+          j += period;
+          memory = m - period - 1;
+        } else {
+          j += i - ell;
+          memory = -1;
+        }
+      }
+    } else {
+      for (int64_t j = 0; j <= textLen - m;) {
+        int i = ell + 1;
+        while (i < m && Traits::FetchByte(x, i) == Traits::FetchByte(y, i + j))
+          ++i;
+        if (i >= m) {
+          i = ell;
+          while (i >= 0 && Traits::FetchByte(x, i) == Traits::FetchByte(y, i + j))
+            --i;
+          if (i < 0) {
+            if (WordTraits::IsWordMatch(textStart, text + textLen, text + j, m))
+              return text + j;
+            // Skip the match, as |FindNextWholeWord| would.
+            j += m;
+            continue;
+          }
+          j += period;
+        } else {
+          j += i - ell;
+        }
+      }
+    }
+
+    return NULL;
+  }
+
+  const char *pattern_;
+  int patternLen_;
+  // Position of the critical factorization (last byte of the left part).
+  int ell_;
+  // Shift applied after a match of the right part.
+  int period_;
+  bool periodic_;
+};
@@ -0,0 +1,81 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "search_base.h"
+
+// Support for the search algorithms of UTF-16 text, which are
+// |AsciiSearchBase| implementations where the pattern and the text are
+// wchar_t strings: |SearchParams64| pointers point to wchar_t characters, and
+// lengths (pattern, text and match) are in characters. Match offsets reported
+// by |FindAll| are in bytes, as for ASCII text.
+//
+// As with the ASCII algorithms, case insensitive searches only fold 'A' to
+// 'Z', and word characters are ASCII letters, digits and '_'.
+
+template <typename T>
+struct Utf16SearchCaseMode {
+  static wchar_t FetchChar(const wchar_t* text, int64_t index);
+};
+
+template <>
+struct Utf16SearchCaseMode<CaseSensitive> {
+  static const bool kMatchCase = true;
+  static wchar_t FetchChar(const wchar_t* text, int64_t index) {
+    return text[index];
+  }
+};
+
+template <>
+struct Utf16SearchCaseMode<CaseInsensitive> {
+  static const bool kMatchCase = false;
+  static wchar_t FetchChar(const wchar_t* text, int64_t index) {
+    wchar_t value = text[index];
+    return (value >= 'A' && value <= 'Z') ? (value | 0x20) : value;
+  }
+};
+
+template <typename W>
+struct Utf16SearchWordMode {
+};
+
+template <>
+struct Utf16SearchWordMode<AnyWord> {
+  static const bool kWholeWord = false;
+  static bool IsWordMatch(const wchar_t* textStart, const wchar_t* textEnd, const wchar_t* matchStart, int matchLength) {
+    return true;
+  }
+};
+
+template <>
+struct Utf16SearchWordMode<WholeWord> {
+  static const bool kWholeWord = true;
+  static bool IsWordMatch(const wchar_t* textStart, const wchar_t* textEnd, const wchar_t* matchStart, int matchLength) {
+    if (matchStart > textStart && IsWordChar(matchStart[-1]))
+      return false;
+    const wchar_t* matchEnd = matchStart + matchLength;
+    if (matchEnd < textEnd && IsWordChar(*matchEnd))
+      return false;
+    return true;
+  }
+
+ private:
+  static bool IsWordChar(wchar_t ch) {
+    return ch < 0x80 && AsciiSearchBase::IsWordCharacter(static_cast<uint8_t>(ch));
+  }
+};
+
+// Returns true if the |patternLen| characters at |text| and |pattern| are
+// equal in case mode |T|.
+template <typename T>
+bool Utf16Equal(const wchar_t* text, const wchar_t* pattern, int patternLen) {
+  for (int i = 0; i < patternLen; i++) {
+    if (Utf16SearchCaseMode<T>::FetchChar(text, i) != Utf16SearchCaseMode<T>::FetchChar(pattern, i))
+      return false;
+  }
+  return true;
+}
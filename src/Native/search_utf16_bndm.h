@@ -0,0 +1,95 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "search_utf16.h"
+
+// UTF-16 version of |Bndm64Search|. Tables of 65536 masks per pattern would
+// be too large, so the masks are indexed by the low byte of the characters:
+// the automaton then accepts a superset of the matches, which are verified
+// character by character. Patterns longer than 64 characters are searched
+// with the automaton of their first 64 characters. See search_utf16.h for the
+// parameters of UTF-16 searches.
+template<typename T, typename W = AnyWord>
+class Utf16BndmSearch : public AsciiSearchBase {
+ public:
+  typedef Utf16SearchCaseMode<T> Traits;
+  typedef Utf16SearchWordMode<W> WordTraits;
+
+  Utf16BndmSearch()
+      : pattern_(NULL),
+        patternLen_(0),
+        windowLen_(0) {
+    memset(maskv_, 0, sizeof(maskv_));
+  }
+
+  void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE {
+    pattern_ = reinterpret_cast<const wchar_t*>(pattern);
+    patternLen_ = patternLen;
+    windowLen_ = min(patternLen, 64);
+    for (int i = 0; i < windowLen_; ++i)
+      maskv_[Hash(Traits::FetchChar(pattern_, i))] |= uint64_t(1) << (windowLen_ - 1 - i);
+  }
+
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
+    const wchar_t* textStart = reinterpret_cast<const wchar_t*>(searchParams->TextStart);
+    const wchar_t* text = textStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = reinterpret_cast<const wchar_t*>(searchParams->MatchStart) + searchParams->MatchLength;
+      textLen = textStart + searchParams->TextLength - text;
+    }
+
+    const wchar_t* match = utf16_bndm_algo(text, textLen, textStart);
+    searchParams->MatchStart = reinterpret_cast<const char*>(match);
+    if (match != nullptr) {
+      searchParams->MatchLength = patternLen_;
+    }
+  }
+
+ private:
+  static uint8_t Hash(wchar_t value) {
+    return static_cast<uint8_t>(value);
+  }
+
+  const wchar_t* utf16_bndm_algo(const wchar_t* text, int64_t textLen, const wchar_t* textStart) const {
+    const int patternLen = patternLen_;
+    const int windowLen = windowLen_;
+    if (patternLen <= 0)
+      return NULL;
+
+    const wchar_t* textEnd = text + textLen;
+    int j;
+    for (int64_t i = 0; i <= textLen - patternLen; i += j) {
+      uint64_t mask = maskv_[Hash(Traits::FetchChar(text, i + windowLen - 1))];
+      for (j = windowLen; mask;) {
+        if (!--j) {
+          // The window matches the low bytes of the pattern: verify all the
+          // characters of the pattern, then shift the window by one.
+          j = 1;
+          if (!Utf16Equal<T>(text + i, pattern_, patternLen))
+            break;
+          if (WordTraits::IsWordMatch(textStart, textEnd, text + i, patternLen))
+            return text + i;
+          // Skip the match, as |FindNextWholeWord| would.
+          j = patternLen;
+          break;
+        }
+        mask = (mask << 1) & maskv_[Hash(Traits::FetchChar(text, i + j - 1))];
+      }
+    }
+
+    return NULL;
+  }
+
+  const wchar_t* pattern_;
+  int patternLen_;
+  // Number of characters of the pattern recognized by the automaton.
+  int windowLen_;
+  uint64_t maskv_[kAlphabetLen];
+};
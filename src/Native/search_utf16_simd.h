@@ -0,0 +1,206 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <intrin.h>
+#include <stdint.h>
+
+#include "byte_frequency.h"
+#include "search_utf16.h"
+#include "simd_vector.h"
+
+// UTF-16 version of |SimdLiteralSearch|: for each block of 8 (SSE2) or 16
+// (AVX2) text positions, the two rarest characters of the pattern are
+// compared against the text with 16-bit packed compares, and only the
+// positions where both characters match are verified. See search_utf16.h for
+// the parameters of UTF-16 searches.
+template<typename T, typename W = AnyWord, typename V = Sse2Vector>
+class Utf16SimdSearch : public AsciiSearchBase {
+ public:
+  typedef Utf16SearchCaseMode<T> Traits;
+  typedef Utf16SearchWordMode<W> WordTraits;
+
+  Utf16SimdSearch()
+      : pattern_(NULL),
+        patternLen_(0),
+        anchor1_(0),
+        anchor2_(0),
+        offset1_(0),
+        offset2_(0) {
+  }
+
+  void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE {
+    pattern_ = reinterpret_cast<const wchar_t*>(pattern);
+    patternLen_ = patternLen;
+    if (patternLen > 0) {
+      GetRarestCharOffsets(pattern_, patternLen, (options & kMatchCase) != 0, &offset1_, &offset2_);
+      anchor1_ = Traits::FetchChar(pattern_, offset1_);
+      anchor2_ = Traits::FetchChar(pattern_, offset2_);
+    }
+  }
+
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE {
+    const wchar_t* textStart = reinterpret_cast<const wchar_t*>(searchParams->TextStart);
+    const wchar_t* text = textStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = reinterpret_cast<const wchar_t*>(searchParams->MatchStart) + searchParams->MatchLength;
+      textLen = textStart + searchParams->TextLength - text;
+    }
+
+    const wchar_t* match = utf16_simd_algo(text, textLen, textStart);
+    searchParams->MatchStart = reinterpret_cast<const char*>(match);
+    if (match != nullptr) {
+      searchParams->MatchLength = patternLen_;
+    }
+  }
+
+  virtual int CountWorker(SearchParams64* searchParams, int maxCount) OVERRIDE {
+    const wchar_t* textStart = reinterpret_cast<const wchar_t*>(searchParams->TextStart);
+    const wchar_t* text = textStart;
+    int64_t textLen = searchParams->TextLength;
+    if (searchParams->MatchStart != nullptr) {
+      text = reinterpret_cast<const wchar_t*>(searchParams->MatchStart) + searchParams->MatchLength;
+      textLen = textStart + searchParams->TextLength - text;
+    }
+
+    searchParams->MatchStart = nullptr;
+    return utf16_simd_count(text, textLen, textStart, maxCount);
+  }
+
+ private:
+  static wchar_t ToUpper(wchar_t value) {
+    return (value >= 'a' && value <= 'z') ? (value & ~0x20) : value;
+  }
+
+  // Returns the packed compare of |block| with |value|, and with |valueAlt|
+  // (the upper case version of |value|) for case insensitive searches.
+  static typename V::Type Equal(typename V::Type block, typename V::Type value, typename V::Type valueAlt) {
+    typename V::Type equal = V::CmpEqx16(block, value);
+    if (Traits::kMatchCase)
+      return equal;
+    return V::Or(equal, V::CmpEqx16(block, valueAlt));
+  }
+
+  // Returns the first match in |text|, which ends the searched text starting
+  // at |textStart|. When matching whole words, the search resumes after the
+  // end of the matches that are not whole words.
+  const wchar_t* utf16_simd_algo(const wchar_t* text, int64_t textLen, const wchar_t* textStart) const {
+    const int patternLen = patternLen_;
+    if (patternLen <= 0 || textLen < patternLen)
+      return NULL;
+
+    // Number of characters per block.
+    const int kBlockSize = V::kSize / sizeof(wchar_t);
+    const wchar_t* textEnd = text + textLen;
+    const typename V::Type vanchor1 = V::Set1x16(anchor1_);
+    const typename V::Type vanchor1Alt = V::Set1x16(ToUpper(anchor1_));
+    const typename V::Type vanchor2 = V::Set1x16(anchor2_);
+    const typename V::Type vanchor2Alt = V::Set1x16(ToUpper(anchor2_));
+
+    const wchar_t* result = NULL;
+    // The first position a match can start at.
+    int64_t next = 0;
+    int64_t i = 0;
+    const int64_t blockLimit = textLen - patternLen - (kBlockSize - 1);
+    for (; i <= blockLimit && result == NULL; i += kBlockSize) {
+      typename V::Type block1 = V::Load(reinterpret_cast<const uint8_t*>(text + i + offset1_));
+      typename V::Type block2 = V::Load(reinterpret_cast<const uint8_t*>(text + i + offset2_));
+      typename V::Type eq = V::And(
+        Equal(block1, vanchor1, vanchor1Alt),
+        Equal(block2, vanchor2, vanchor2Alt));
+      // Two bits per character, only the low one is kept.
+      uint32_t mask = V::MoveMask(eq) & 0x55555555;
+      while (mask) {
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        mask &= mask - 1;
+        int64_t position = i + bit / 2;
+        if (position < next || !Utf16Equal<T>(text + position, pattern_, patternLen))
+          continue;
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + position, patternLen)) {
+          result = text + position;
+          break;
+        }
+        next = position + patternLen;
+      }
+    }
+    V::Leave();
+    if (result != NULL)
+      return result;
+
+    // Remaining positions (less than one block)
+    for (i = max(i, next); i <= textLen - patternLen; i++) {
+      if (Utf16Equal<T>(text + i, pattern_, patternLen)) {
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + i, patternLen))
+          return text + i;
+        i += patternLen - 1;
+      }
+    }
+
+    return NULL;
+  }
+
+  // Same as |utf16_simd_algo|, except matches are counted (up to |maxCount|)
+  // without leaving the loop.
+  int utf16_simd_count(const wchar_t* text, int64_t textLen, const wchar_t* textStart, int maxCount) const {
+    const int patternLen = patternLen_;
+    if (patternLen <= 0 || textLen < patternLen || maxCount <= 0)
+      return 0;
+
+    const int kBlockSize = V::kSize / sizeof(wchar_t);
+    const wchar_t* textEnd = text + textLen;
+    const typename V::Type vanchor1 = V::Set1x16(anchor1_);
+    const typename V::Type vanchor1Alt = V::Set1x16(ToUpper(anchor1_));
+    const typename V::Type vanchor2 = V::Set1x16(anchor2_);
+    const typename V::Type vanchor2Alt = V::Set1x16(ToUpper(anchor2_));
+
+    int count = 0;
+    // The first position a match can start at.
+    int64_t next = 0;
+    int64_t i = 0;
+    const int64_t blockLimit = textLen - patternLen - (kBlockSize - 1);
+    for (; i <= blockLimit && count < maxCount; i += kBlockSize) {
+      typename V::Type block1 = V::Load(reinterpret_cast<const uint8_t*>(text + i + offset1_));
+      typename V::Type block2 = V::Load(reinterpret_cast<const uint8_t*>(text + i + offset2_));
+      typename V::Type eq = V::And(
+        Equal(block1, vanchor1, vanchor1Alt),
+        Equal(block2, vanchor2, vanchor2Alt));
+      uint32_t mask = V::MoveMask(eq) & 0x55555555;
+      while (mask) {
+        unsigned long bit;
+        _BitScanForward(&bit, mask);
+        mask &= mask - 1;
+        int64_t position = i + bit / 2;
+        if (position < next || !Utf16Equal<T>(text + position, pattern_, patternLen))
+          continue;
+        next = position + patternLen;
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + position, patternLen)) {
+          if (++count == maxCount)
+            break;
+        }
+      }
+    }
+    V::Leave();
+
+    // Remaining positions (less than one block)
+    for (i = max(i, next); i <= textLen - patternLen && count < maxCount; i++) {
+      if (Utf16Equal<T>(text + i, pattern_, patternLen)) {
+        if (WordTraits::IsWordMatch(textStart, textEnd, text + i, patternLen))
+          count++;
+        i += patternLen - 1;
+      }
+    }
+
+    return count;
+  }
+
+  const wchar_t* pattern_;
+  int patternLen_;
+  wchar_t anchor1_;
+  wchar_t anchor2_;
+  int offset1_;
+  int offset2_;
+};
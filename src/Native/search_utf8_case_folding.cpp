@@ -0,0 +1,328 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "search_utf8_case_folding.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ascii_fold.h"
+#include "re2/re2_casefold.h"
+
+namespace {
+
+const int kWindowSize = 4096;
+
+// Text starting with at least this many ASCII characters is searched in
+// place, see |FoldedWindow::ascii|.
+const int kMinAsciiWindow = 1024;
+
+// Maximum length of the text looked at when filling a window. ASCII windows
+// are searched in place, and can be that long.
+const int64_t kMaxWindowSourceLength = 1 << 30;
+
+// A window ends early once this many runes have been folded to a shorter
+// sequence. Runes never fold to a longer sequence, as the representative of
+// an orbit is its smallest rune, so a window always contains at least
+// |kMaxShifts| bytes, i.e. more than a pattern.
+const int kMaxShifts = Utf8CaseFoldingSearch::kMaxPatternLength;
+
+// The difference between original and folded offsets, starting at
+// |foldedOffset|.
+struct OffsetShift {
+  int foldedOffset;
+  int delta;
+};
+
+// Layout of the search buffer.
+struct FoldedWindow {
+  // The start of the window in the original text, or nullptr if the window
+  // has not been filled yet.
+  const char* source;
+  int sourceLength;
+  int length;
+  // True if the window is made of ASCII characters only, in which case it is
+  // not folded into |text|.
+  bool ascii;
+  int shiftCount;
+  OffsetShift shifts[kMaxShifts];
+  char text[kWindowSize];
+};
+
+// Decodes the UTF-8 sequence at the start of |text| into |rune|, and returns
+// its length, or 0 if |text| does not start with a valid sequence.
+int DecodeRune(const uint8_t* text, int textLen, int* rune) {
+  uint8_t lead = text[0];
+  int length;
+  int value;
+  if (lead < 0xC2 || lead > 0xF4) {
+    return 0;
+  } else if (lead < 0xE0) {
+    length = 2;
+    value = lead & 0x1F;
+  } else if (lead < 0xF0) {
+    length = 3;
+    value = lead & 0x0F;
+  } else {
+    length = 4;
+    value = lead & 0x07;
+  }
+  if (textLen < length)
+    return 0;
+
+  for (int i = 1; i < length; i++) {
+    if ((text[i] & 0xC0) != 0x80)
+      return 0;
+    value = (value << 6) | (text[i] & 0x3F);
+  }
+
+  // Overlong sequences, surrogates and values beyond U+10FFFF.
+  if ((length == 3 && value < 0x800) ||
+      (length == 4 && (value < 0x10000 || value > 0x10FFFF)) ||
+      (value >= 0xD800 && value <= 0xDFFF)) {
+    return 0;
+  }
+  *rune = value;
+  return length;
+}
+
+// Stores the UTF-8 sequence of |rune| (which is not ASCII) in |dst|, and
+// returns its length.
+int EncodeRune(int rune, uint8_t* dst) {
+  if (rune < 0x800) {
+    dst[0] = static_cast<uint8_t>(0xC0 | (rune >> 6));
+    dst[1] = static_cast<uint8_t>(0x80 | (rune & 0x3F));
+    return 2;
+  }
+  if (rune < 0x10000) {
+    dst[0] = static_cast<uint8_t>(0xE0 | (rune >> 12));
+    dst[1] = static_cast<uint8_t>(0x80 | ((rune >> 6) & 0x3F));
+    dst[2] = static_cast<uint8_t>(0x80 | (rune & 0x3F));
+    return 3;
+  }
+  dst[0] = static_cast<uint8_t>(0xF0 | (rune >> 18));
+  dst[1] = static_cast<uint8_t>(0x80 | ((rune >> 12) & 0x3F));
+  dst[2] = static_cast<uint8_t>(0x80 | ((rune >> 6) & 0x3F));
+  dst[3] = static_cast<uint8_t>(0x80 | (rune & 0x3F));
+  return 4;
+}
+
+// Folds |src| into |dst|, stopping when |dst| is full or when |maxShifts|
+// runes have been folded to a shorter sequence. Stores the number of bytes of
+// |src| folded in |srcFolded| and returns the number of bytes stored in
+// |dst|. The offsets where folding shortens the text are stored in |shifts|,
+// unless |shifts| is null.
+//
+// If |stopAtAsciiRun| is true, folding also stops at the first long run of
+// ASCII characters (unless it starts |src|), after its first
+// |kMaxPatternLength| bytes, so that the rest of the run is searched in
+// place.
+int FoldUtf8(const char* src, int srcLen, char* dst, int dstCapacity,
+             OffsetShift* shifts, int maxShifts, int* shiftCount, int* srcFolded,
+             bool stopAtAsciiRun) {
+  const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+  uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+  int i = 0;
+  int j = 0;
+  while (i < srcLen && j < dstCapacity) {
+    if (s[i] < 0x80) {
+      int run = AsciiPrefixLength(src + i, min(srcLen - i, dstCapacity - j));
+      bool stop = stopAtAsciiRun && j > 0 &&
+        run >= kMinAsciiWindow + Utf8CaseFoldingSearch::kMaxPatternLength;
+      if (stop)
+        run = Utf8CaseFoldingSearch::kMaxPatternLength;
+      AsciiFoldToLower(src + i, dst + j, run);
+      i += run;
+      j += run;
+      if (stop)
+        break;
+      continue;
+    }
+
+    int rune;
+    int length = DecodeRune(s + i, srcLen - i, &rune);
+    if (length == 0) {
+      d[j++] = s[i++];
+      continue;
+    }
+
+    uint8_t folded[4];
+    int foldedRune = RE2CaseFoldRune(rune);
+    int foldedLength;
+    if (foldedRune < 0x80) {
+      folded[0] = static_cast<uint8_t>(foldedRune);
+      foldedLength = 1;
+    } else {
+      foldedLength = EncodeRune(foldedRune, folded);
+    }
+    if (j + foldedLength > dstCapacity)
+      break;
+    if (foldedLength != length && shifts != nullptr) {
+      if (*shiftCount == maxShifts)
+        break;
+      OffsetShift& shift = shifts[(*shiftCount)++];
+      shift.foldedOffset = j + foldedLength;
+      shift.delta = (i + length) - (j + foldedLength);
+    }
+    memcpy(d + j, folded, foldedLength);
+    i += length;
+    j += foldedLength;
+  }
+  *srcFolded = i;
+  return j;
+}
+
+// Returns the offset in the original text of the folded offset |offset|.
+int SourceOffset(const FoldedWindow* window, int offset) {
+  int delta = 0;
+  for (int i = 0; i < window->shiftCount && window->shifts[i].foldedOffset <= offset; i++) {
+    delta = window->shifts[i].delta;
+  }
+  return offset + delta;
+}
+
+// Returns the folded offset of the offset |sourceOffset| of the original
+// text.
+int FoldedOffset(const FoldedWindow* window, int sourceOffset) {
+  int delta = 0;
+  for (int i = 0; i < window->shiftCount; i++) {
+    const OffsetShift& shift = window->shifts[i];
+    if (shift.foldedOffset + shift.delta > sourceOffset)
+      break;
+    delta = shift.delta;
+  }
+  return sourceOffset - delta;
+}
+
+}  // namespace
+
+Utf8CaseFoldingSearch::Utf8CaseFoldingSearch(AsciiSearchBase* search, AsciiSearchBase* asciiSearch)
+    : search_(search),
+      asciiSearch_(asciiSearch),
+      asciiPattern_(false) {
+}
+
+Utf8CaseFoldingSearch::~Utf8CaseFoldingSearch() {
+  delete search_;
+  delete asciiSearch_;
+}
+
+int Utf8CaseFoldingSearch::GetSearchBufferSize() {
+  return sizeof(FoldedWindow);
+}
+
+void Utf8CaseFoldingSearch::StartSearchWorker(
+    const char *pattern,
+    int patternLen,
+    SearchOptions options,
+    SearchCreateResult& result) {
+  // Folding never makes the pattern longer.
+  foldedPattern_.resize(patternLen);
+  int shiftCount = 0;
+  int patternFolded;
+  int foldedLen = FoldUtf8(pattern, patternLen, &foldedPattern_[0], patternLen,
+                           nullptr, 0, &shiftCount, &patternFolded, false);
+  foldedPattern_.resize(foldedLen);
+  if (foldedLen > kMaxPatternLength) {
+    result.SetError(E_INVALIDARG, "Pattern is too long for case folding search");
+    return;
+  }
+
+  asciiPattern_ = AsciiPrefixLength(foldedPattern_.data(), foldedLen) == foldedLen;
+
+  // Whole word matching is performed by this instance on the original text.
+  int searchOptions = (options | kMatchCase) & ~kMatchWholeWord;
+  search_->StartSearch(
+    foldedPattern_.data(),
+    foldedLen,
+    static_cast<SearchOptions>(searchOptions),
+    result);
+  if (FAILED(result.HResult))
+    return;
+
+  int asciiSearchOptions = options & ~(kMatchCase | kMatchWholeWord);
+  asciiSearch_->StartSearch(
+    foldedPattern_.data(),
+    foldedLen,
+    static_cast<SearchOptions>(asciiSearchOptions),
+    result);
+}
+
+void Utf8CaseFoldingSearch::FindNextWorker(SearchParams64* searchParams) {
+  FoldedWindow* window = reinterpret_cast<FoldedWindow*>(searchParams->SearchBuffer);
+  const int patternLen = static_cast<int>(foldedPattern_.size());
+  const char* textEnd = searchParams->TextStart + searchParams->TextLength;
+  const char* start = searchParams->TextStart;
+  if (searchParams->MatchStart == nullptr) {
+    window->source = nullptr;
+  } else {
+    start = searchParams->MatchStart + searchParams->MatchLength;
+  }
+
+  while (true) {
+    // Refill the window unless it contains all the text needed to look for
+    // a match starting at |start|.
+    const char* windowEnd = window->source + window->sourceLength;
+    bool windowValid =
+      window->source != nullptr &&
+      window->source <= start &&
+      start <= windowEnd &&
+      (FoldedOffset(window, static_cast<int>(start - window->source)) + patternLen <= window->length ||
+       windowEnd == textEnd);
+    if (!windowValid) {
+      const int textLen = static_cast<int>(min(textEnd - start, kMaxWindowSourceLength));
+      const int asciiLen = AsciiPrefixLength(start, textLen);
+      window->source = start;
+      window->shiftCount = 0;
+      window->ascii = asciiLen >= min(textLen, kMinAsciiWindow);
+      if (window->ascii) {
+        window->length = asciiLen;
+        window->sourceLength = asciiLen;
+      } else {
+        int sourceLength;
+        window->length = FoldUtf8(
+          start, textLen, window->text, kWindowSize,
+          window->shifts, kMaxShifts, &window->shiftCount, &sourceLength, true);
+        window->sourceLength = sourceLength;
+      }
+      windowEnd = window->source + window->sourceLength;
+    }
+
+    // ASCII windows never match a pattern that does not fold to ASCII.
+    const char* windowText = window->ascii ? window->source : window->text;
+    const int offset = FoldedOffset(window, static_cast<int>(start - window->source));
+    SearchParams64 params = SearchParams64();
+    params.TextStart = windowText + offset;
+    params.TextLength = window->length - offset;
+    if (!window->ascii)
+      search_->FindNext(&params);
+    else if (asciiPattern_)
+      asciiSearch_->FindNext(&params);
+    if (params.MatchStart != nullptr) {
+      const int matchOffset = static_cast<int>(params.MatchStart - windowText);
+      const int matchStart = SourceOffset(window, matchOffset);
+      // The match is inside the window, whose length is an int.
+      const int matchEnd = SourceOffset(window, matchOffset + static_cast<int>(params.MatchLength));
+      searchParams->MatchStart = window->source + matchStart;
+      searchParams->MatchLength = matchEnd - matchStart;
+      return;
+    }
+
+    if (windowEnd == textEnd) {
+      searchParams->MatchStart = nullptr;
+      searchParams->MatchLength = 0;
+      return;
+    }
+
+    // Next window overlaps the current one so that matches spanning both
+    // windows are found. The overlap may start in the middle of a rune,
+    // whose remaining bytes are then searched as is, which is fine as
+    // matches never start with a continuation byte.
+    const int overlap = max(window->length - max(patternLen - 1, 0), 0);
+    start = max(start, window->source + SourceOffset(window, overlap));
+  }
+}
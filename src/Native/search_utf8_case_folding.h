@@ -0,0 +1,51 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <string>
+
+#include "search_base.h"
+
+// Case insensitive search of UTF-8 text using Unicode simple case folding
+// (e.g. U+00C9 matches U+00E9). As with |CaseFoldingSearch|, the text is
+// folded one window at a time and the folded window is searched with a case
+// sensitive algorithm. Runs of ASCII characters are folded with vector
+// instructions (see |AsciiFoldToLower|), other runes are decoded and folded
+// with the case folding tables of RE2 (see |RE2CaseFoldRune|).
+//
+// Windows made of ASCII characters only, i.e. most of the text of source
+// files, are not folded: they are searched in place with a case insensitive
+// ASCII algorithm, which runs at the speed of the ASCII search.
+//
+// Folding may change the length of a rune (e.g. the Kelvin sign folds to
+// 'k'), so the window records the positions where folded and original
+// offsets start to differ, to report matches in the original text.
+//
+// Bytes that are not part of a valid UTF-8 sequence are searched as is.
+class Utf8CaseFoldingSearch : public AsciiSearchBase {
+ public:
+  // Folded patterns must be significantly shorter than the folding window.
+  enum { kMaxPatternLength = 256 };
+
+  // Takes ownership of |search|, which must be a case sensitive algorithm,
+  // and of |asciiSearch|, which must be a case insensitive algorithm. Neither
+  // may use a search buffer.
+  Utf8CaseFoldingSearch(AsciiSearchBase* search, AsciiSearchBase* asciiSearch);
+  virtual ~Utf8CaseFoldingSearch();
+
+  virtual int GetSearchBufferSize() OVERRIDE;
+
+ protected:
+  virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+
+ private:
+  AsciiSearchBase* search_;
+  AsciiSearchBase* asciiSearch_;
+  std::string foldedPattern_;
+  // True if the folded pattern is made of ASCII characters only, i.e. if it
+  // may match ASCII text.
+  bool asciiPattern_;
+};
@@ -0,0 +1,216 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stdafx.h"
+
+#include "search_wildcard.h"
+
+#include <string.h>
+
+#include "line_extent.h"
+
+namespace {
+
+// Layout of the start of the search buffer. The buffers of the longest entry
+// and of the other entries follow.
+struct WildcardState {
+  // The search state of the longest entry.
+  AsciiSearchBase::SearchParams64 mainParams;
+  // The end of the match of the longest entry before the current one, see
+  // |AsciiSearchBase::GetCandidateEnd|.
+  const char* candidateEnd;
+};
+
+}  // namespace
+
+WildcardSearch::WildcardSearch(
+    CreateEntrySearchFunction createEntrySearch,
+    SearchOptions entryOptions)
+    : createEntrySearch_(createEntrySearch),
+      entryOptions_(entryOptions),
+      mainEntry_(0),
+      entryBufferSize_(0),
+      matchWholeWord_((entryOptions & kMatchWholeWord) != 0) {
+}
+
+WildcardSearch::~WildcardSearch() {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    delete entries_[i];
+  }
+}
+
+int WildcardSearch::GetSearchBufferSize() {
+  return sizeof(WildcardState) + 2 * entryBufferSize_;
+}
+
+void WildcardSearch::StartSearchWorker(
+    const char *pattern,
+    int patternLen,
+    SearchOptions options,
+    SearchCreateResult& result) {
+  std::vector<Range> entryPatterns;
+  int mainEntryLen = 0;
+  int start = 0;
+  for (int i = 0; i <= patternLen; i++) {
+    if (i < patternLen && pattern[i] != kEntrySeparator)
+      continue;
+
+    int len = i - start;
+    if (len > 0) {
+      // The first longest entry is the main entry.
+      if (len > mainEntryLen) {
+        mainEntry_ = static_cast<int>(entryPatterns.size());
+        mainEntryLen = len;
+      }
+      Range entryPattern = { pattern + start, pattern + i };
+      entryPatterns.push_back(entryPattern);
+    }
+    start = i + 1;
+  }
+
+  if (entryPatterns.empty()) {
+    result.SetError(E_INVALIDARG, "Pattern list is empty");
+    return;
+  }
+
+  for (size_t i = 0; i < entryPatterns.size(); i++) {
+    // Whole word matching of the main entry is checked by |FindNextWorker|,
+    // which goes through all the matches of the main entry.
+    SearchOptions entryOptions = entryOptions_;
+    if (static_cast<int>(i) == mainEntry_)
+      entryOptions = static_cast<SearchOptions>(entryOptions & ~kMatchWholeWord);
+    const Range& entryPattern = entryPatterns[i];
+    AsciiSearchBase* entry = createEntrySearch_(
+        entryPattern.start,
+        static_cast<int>(entryPattern.end - entryPattern.start),
+        entryOptions,
+        &result);
+    if (FAILED(result.HResult))
+      return;
+
+    entryBufferSize_ = max(entryBufferSize_, entry->GetSearchBufferSize());
+    entries_.push_back(entry);
+  }
+}
+
+void WildcardSearch::FindNextWorker(SearchParams64* searchParams) {
+  WildcardState* state = reinterpret_cast<WildcardState*>(searchParams->SearchBuffer);
+  char* mainBuffer = reinterpret_cast<char*>(state + 1);
+  char* entryBuffer = mainBuffer + entryBufferSize_;
+
+  const char* previousEnd = nullptr;
+  if (searchParams->MatchStart == nullptr) {
+    memset(&state->mainParams, 0, sizeof(state->mainParams));
+    state->mainParams.TextStart = searchParams->TextStart;
+    state->mainParams.TextLength = searchParams->TextLength;
+    state->mainParams.SearchBuffer = mainBuffer;
+    state->candidateEnd = nullptr;
+  } else {
+    previousEnd = searchParams->MatchStart + searchParams->MatchLength;
+  }
+
+  const char* context = searchParams->TextStart;
+  int64_t contextLen = searchParams->TextLength;
+  if (searchParams->ContextStart != nullptr) {
+    context = searchParams->ContextStart;
+    contextLen = searchParams->ContextLength;
+  }
+
+  AsciiSearchBase* mainEntry = entries_[mainEntry_];
+  const int entryCount = static_cast<int>(entries_.size());
+  while (true) {
+    if (state->mainParams.MatchStart != nullptr)
+      state->candidateEnd = state->mainParams.MatchStart + state->mainParams.MatchLength;
+    mainEntry->FindNext(&state->mainParams);
+    if (state->mainParams.MatchStart == nullptr) {
+      searchParams->MatchStart = nullptr;
+      searchParams->MatchLength = 0;
+      return;
+    }
+
+    Range match = {
+      state->mainParams.MatchStart,
+      state->mainParams.MatchStart + state->mainParams.MatchLength
+    };
+    // Matches can't overlap with the previous one, nor start before the
+    // context (e.g. before the end of the previous match of a
+    // |StreamingSearch|).
+    if ((previousEnd != nullptr && match.start < previousEnd) || match.start < context)
+      continue;
+
+    int64_t lineStart, lineLen, lineEndStart, lineEndLen;
+    GetLineExtentFromPosition(context, contextLen, match.start - context,
+                              kMaxLineExtentOffset, &lineStart, &lineLen);
+    GetLineExtentFromPosition(context, contextLen, match.end - context,
+                              kMaxLineExtentOffset, &lineEndStart, &lineEndLen);
+    Range line = { context + lineStart, context + lineEndStart + lineEndLen };
+    if (previousEnd != nullptr && line.start < previousEnd)
+      line.start = previousEnd;
+    // As for the other entries, whole word matching applies inside the
+    // line, which does not depend on where the searched text ends.
+    if (matchWholeWord_ &&
+        !IsWholeWordMatch(line.start, line.end, match.start, match.end - match.start)) {
+      continue;
+    }
+
+    // Look for the entries before and after the main entry, in order.
+    Range first = match;
+    if (mainEntry_ > 0) {
+      Range before = { line.start, match.start };
+      if (!FindEntries(0, mainEntry_, entryBuffer, before, &first))
+        continue;
+    }
+    Range last = match;
+    if (mainEntry_ + 1 < entryCount) {
+      Range after = { match.end, line.end };
+      if (!FindEntries(mainEntry_ + 1, entryCount, entryBuffer, after, &last))
+        continue;
+    }
+
+    searchParams->MatchStart = first.start;
+    searchParams->MatchLength = last.end - first.start;
+    return;
+  }
+}
+
+const char* WildcardSearch::GetCandidateEnd(const SearchParams64* searchParams) {
+  const WildcardState* state = reinterpret_cast<const WildcardState*>(searchParams->SearchBuffer);
+  return state->candidateEnd;
+}
+
+void WildcardSearch::CancelSearch(SearchParams64* searchParams) {
+  WildcardState* state = reinterpret_cast<WildcardState*>(searchParams->SearchBuffer);
+  if (state->mainParams.MatchStart != nullptr)
+    entries_[mainEntry_]->CancelSearch(&state->mainParams);
+}
+
+bool WildcardSearch::FindEntry(AsciiSearchBase* entry, void* searchBuffer, Range* range) {
+  SearchParams64 params;
+  memset(&params, 0, sizeof(params));
+  params.TextStart = range->start;
+  params.TextLength = range->end - range->start;
+  params.SearchBuffer = searchBuffer;
+  entry->FindNext(&params);
+  if (params.MatchStart == nullptr)
+    return false;
+
+  range->start = params.MatchStart;
+  range->end = params.MatchStart + params.MatchLength;
+  entry->CancelSearch(&params);
+  return true;
+}
+
+bool WildcardSearch::FindEntries(int first, int last, void* searchBuffer, Range range, Range* result) {
+  for (int i = first; i < last; i++) {
+    Range found = range;
+    if (!FindEntry(entries_[i], searchBuffer, &found))
+      return false;
+
+    if (i == first)
+      result->start = found.start;
+    result->end = found.end;
+    range.start = found.end;
+  }
+  return true;
+}
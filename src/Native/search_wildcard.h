@@ -0,0 +1,69 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <vector>
+
+#include "search_base.h"
+
+// Search for a list of entries appearing in order on the same line (i.e.
+// "foo*bar" search strings). The entries are passed to |StartSearch| as a
+// single string, separated by |kEntrySeparator|.
+//
+// The longest entry is searched first in the text. For each of its matches,
+// the entries before and after it are searched in the extent of the line
+// around the match, and the reported match spans from the first to the last
+// entry. Matches never overlap with the previous match, and the line extent
+// is shrunk to start after it.
+//
+// The extent of lines is computed from |SearchParams64::ContextStart| when
+// available, so that lines crossing the boundaries of the searched text are
+// handled.
+class WildcardSearch : public AsciiSearchBase {
+ public:
+  enum { kEntrySeparator = '\n' };
+  // Must match |FileContents.MaxLineExtentOffset|.
+  enum { kMaxLineExtentOffset = 1024 };
+
+  typedef AsciiSearchBase* (*CreateEntrySearchFunction)(
+      const char* pattern,
+      int patternLen,
+      SearchOptions options,
+      SearchCreateResult* result);
+
+  // |createEntrySearch| is used to create the search algorithm of each entry
+  // with |entryOptions|. Note that whole word matching applies to each entry,
+  // not to the reported match, and that word boundaries are checked inside
+  // the line extent, like the other entries, for the longest entry too.
+  WildcardSearch(CreateEntrySearchFunction createEntrySearch, SearchOptions entryOptions);
+  virtual ~WildcardSearch();
+
+  virtual int GetSearchBufferSize() OVERRIDE;
+  virtual int GetContextLength() OVERRIDE { return kMaxLineExtentOffset; }
+  virtual const char* GetCandidateEnd(const SearchParams64* searchParams) OVERRIDE;
+  virtual void CancelSearch(SearchParams64* searchParams) OVERRIDE;
+
+ protected:
+  virtual void StartSearchWorker(const char *pattern, int patternLen, SearchOptions options, SearchCreateResult& result) OVERRIDE;
+  virtual void FindNextWorker(SearchParams64* searchParams) OVERRIDE;
+
+ private:
+  struct Range {
+    const char* start;
+    const char* end;
+  };
+
+  bool FindEntry(AsciiSearchBase* entry, void* searchBuffer, Range* range);
+  bool FindEntries(int first, int last, void* searchBuffer, Range range, Range* result);
+
+  CreateEntrySearchFunction createEntrySearch_;
+  SearchOptions entryOptions_;
+  // Searches for each entry, in search string order.
+  std::vector<AsciiSearchBase*> entries_;
+  // The index of the longest entry in |entries_|.
+  int mainEntry_;
+  int entryBufferSize_;
+  bool matchWholeWord_;
+};
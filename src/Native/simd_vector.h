@@ -0,0 +1,95 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <immintrin.h>
+#include <stdint.h>
+
+// Thin wrappers around SSE2 and AVX2 integer intrinsics, so that search
+// algorithms can be written once and instantiated for each register width.
+// The "x16" variants operate on 16-bit lanes (e.g. UTF-16 characters).
+//
+// Note: AVX2 instantiations must only be used if |GetCpuFeatures()| reports
+// |kCpuFeatureAvx2|.
+
+struct Sse2Vector {
+  typedef __m128i Type;
+  enum { kSize = 16 };
+
+  static Type Set1(uint8_t value) {
+    return _mm_set1_epi8(static_cast<char>(value));
+  }
+  static Type Set1x16(uint16_t value) {
+    return _mm_set1_epi16(static_cast<short>(value));
+  }
+  static Type Load(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  static Type CmpEq(Type a, Type b) {
+    return _mm_cmpeq_epi8(a, b);
+  }
+  static Type CmpEqx16(Type a, Type b) {
+    return _mm_cmpeq_epi16(a, b);
+  }
+  // Note: Signed comparison.
+  static Type CmpGt(Type a, Type b) {
+    return _mm_cmpgt_epi8(a, b);
+  }
+  static Type And(Type a, Type b) {
+    return _mm_and_si128(a, b);
+  }
+  static Type Or(Type a, Type b) {
+    return _mm_or_si128(a, b);
+  }
+  static uint32_t MoveMask(Type a) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(a));
+  }
+  static void Store(uint8_t* p, Type a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a);
+  }
+  static void Leave() {
+  }
+};
+
+struct Avx2Vector {
+  typedef __m256i Type;
+  enum { kSize = 32 };
+
+  static Type Set1(uint8_t value) {
+    return _mm256_set1_epi8(static_cast<char>(value));
+  }
+  static Type Set1x16(uint16_t value) {
+    return _mm256_set1_epi16(static_cast<short>(value));
+  }
+  static Type Load(const uint8_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static Type CmpEq(Type a, Type b) {
+    return _mm256_cmpeq_epi8(a, b);
+  }
+  static Type CmpEqx16(Type a, Type b) {
+    return _mm256_cmpeq_epi16(a, b);
+  }
+  // Note: Signed comparison.
+  static Type CmpGt(Type a, Type b) {
+    return _mm256_cmpgt_epi8(a, b);
+  }
+  static Type And(Type a, Type b) {
+    return _mm256_and_si256(a, b);
+  }
+  static Type Or(Type a, Type b) {
+    return _mm256_or_si256(a, b);
+  }
+  static uint32_t MoveMask(Type a) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(a));
+  }
+  static void Store(uint8_t* p, Type a) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+  }
+  // Avoid AVX to SSE transition penalties in the code following the loop.
+  static void Leave() {
+    _mm256_zeroupper();
+  }
+};
@@ -3,6 +3,10 @@
 // found in the LICENSE file.
 
 using System;
+using System.Collections.Generic;
+using System.Linq;
+using VsChromium.Core.Logging;
+using VsChromium.Core.Utility;
 using VsChromium.Server.NativeInterop;
 using VsChromium.Server.Search;
 
@@ -12,15 +16,141 @@ namespace VsChromium.Server.FileSystemContents {
   /// values are less than 127).
   /// </summary>
   public class AsciiFileContents : FileContents {
+    /// <summary>
+    /// Patterns shorter than this are searched with the default algorithm
+    /// even if periodic, as verifying a candidate costs only a few compares.
+    /// </summary>
+    private const int MinPeriodicPatternLength = 8;
+
     public AsciiFileContents(FileContentsMemory contents, DateTime utcLastModified)
       : base(contents, utcLastModified) {
     }
 
+    /// <summary>
+    /// Find all instances of the search pattern stored in <paramref
+    /// name="compiledTextSearchData"/> within each of <paramref
+    /// name="pieces"/>, which must all be <see cref="AsciiFileContents"/>
+    /// pieces, using a single native call for many pieces. Returns
+    /// <code>null</code> if the search cannot be batched (e.g. the search
+    /// string contains wildcards), in which case each piece should be
+    /// searched with <see cref="FileContentsPiece.FindAll"/>.
+    /// </summary>
+    public static IList<TextRange>[] FindAllInPieces(
+      CompiledTextSearchData compiledTextSearchData,
+      IList<FileContentsPiece> pieces,
+      IOperationProgressTracker progressTracker) {
+      var parsedSearchString = compiledTextSearchData.ParsedSearchString;
+      if (parsedSearchString.EntriesBeforeLongestEntry.Count != 0 ||
+          parsedSearchString.EntriesAfterLongestEntry.Count != 0) {
+        return null;
+      }
+
+      var textSearch = compiledTextSearchData
+        .GetSearchContainer(parsedSearchString.LongestEntry)
+        .GetAsciiSearch() as AsciiCompiledTextSearchNative;
+      if (textSearch == null)
+        return null;
+
+      var fragments = pieces
+        .Select(x => ((AsciiFileContents)x.FileContents).CreateFragmentFromRange(x.TextRange))
+        .ToList();
+      return textSearch.FindAllFragments(fragments, progressTracker);
+    }
+
     protected override ITextLineOffsets GetFileOffsets() {
       return new AsciiTextLineOffsets(Contents);
     }
 
+    private static void LogCompiledPatternCacheStatistics() {
+      NativeMethods.CompiledPatternCacheStatistics statistics;
+      NativeMethods.CompiledPatternCache_GetStatistics(out statistics);
+      Logger.LogInfo("Compiled regex cache: {0} hits, {1} misses, {2} evictions, {3}/{4} entries",
+        statistics.Hits, statistics.Misses, statistics.Evictions, statistics.EntryCount, statistics.Capacity);
+    }
+
     public static ICompiledTextSearch CreateSearchAlgo(string pattern, SearchProviderOptions searchOptions) {
+      var options = GetNativeSearchOptions(searchOptions);
+
+      if (searchOptions.UseMultiLiteral)
+        return new AsciiCompiledTextSearchMultiLiteral(pattern.Split('|'), options);
+
+      if (searchOptions.UseRegex && searchOptions.UseRe2Engine) {
+        var re2Search = new AsciiCompiledTextSearchRe2(pattern, options);
+        var atoms = re2Search.PrefilterAtoms;
+        Logger.LogInfo("RE2 prefilter atoms for \"{0}\": {1}",
+          pattern, atoms.Count == 0 ? "none" : string.Join(", ", atoms));
+        LogCompiledPatternCacheStatistics();
+        return re2Search;
+      }
+
+      if (searchOptions.UseRegex) {
+        var regexSearch = new AsciiCompiledTextSearchRegex(pattern, options);
+        Logger.LogInfo("Regex \"{0}\" searched with {1}", pattern, regexSearch.Engine);
+        LogCompiledPatternCacheStatistics();
+        return regexSearch;
+      }
+
+      if (searchOptions.MaxErrors > 0)
+        return new AsciiCompiledTextSearchApproximate(pattern, searchOptions.MaxErrors, options);
+
+      // UTF-8 files are loaded as ASCII files, so non ASCII patterns are
+      // folded with the Unicode case folding tables. ASCII patterns keep the
+      // ASCII algorithms, which only miss equivalents such as the Kelvin
+      // sign for 'k'.
+      if (!searchOptions.MatchCase && pattern.Any(c => c >= 0x80))
+        return new AsciiCompiledTextSearchUtf8CaseFolding(pattern, options);
+
+      // Periodic patterns (e.g. "========") match partially at most
+      // positions of repetitive text, which makes verifying each candidate
+      // position quadratic. Two-Way is slower on average, but linear.
+      if (IsPeriodicPattern(pattern, searchOptions.MatchCase))
+        return new AsciiCompiledTextSearchTwoWay(pattern, options);
+
+      // The SIMD kernel usually beats BNDM and Boyer-Moore, but not always:
+      // its throughput depends on how common the characters of the pattern
+      // are in the files loaded, so the algorithms are timed on a sample of
+      // these files instead of being selected on the pattern length.
+      var search = AsciiCompiledTextSearchBest.Create(pattern, options);
+      Logger.LogInfo("Search algorithm for \"{0}\": {1} ({2:n0} MB/s on {3:n0} bytes)",
+        pattern, search.Kind, search.BytesPerSecond / (1024 * 1024), search.SampleLength);
+      return search;
+    }
+
+    /// <summary>
+    /// Returns <code>true</code> if <paramref name="pattern"/> is long
+    /// enough for candidate verification to be costly, and is made of at
+    /// least two repetitions of its smallest period.
+    /// </summary>
+    private static bool IsPeriodicPattern(string pattern, bool matchCase) {
+      if (pattern.Length < MinPeriodicPatternLength)
+        return false;
+
+      if (!matchCase)
+        pattern = pattern.ToLowerInvariant();
+
+      // Compute the longest border (proper prefix that is also a suffix) of
+      // the pattern, as in the Knuth-Morris-Pratt failure function.
+      var border = new int[pattern.Length];
+      var length = 0;
+      for (var i = 1; i < pattern.Length; i++) {
+        while (length > 0 && pattern[i] != pattern[length])
+          length = border[length - 1];
+        if (pattern[i] == pattern[length])
+          length++;
+        border[i] = length;
+      }
+
+      var period = pattern.Length - border[pattern.Length - 1];
+      return period * 2 <= pattern.Length;
+    }
+
+    public static AsciiCompiledTextSearchWildcard CreateWildcardSearchAlgo(
+      IEnumerable<string> entries,
+      SearchProviderOptions searchOptions) {
+      return new AsciiCompiledTextSearchWildcard(entries, GetNativeSearchOptions(searchOptions));
+    }
+
+    private static NativeMethods.SearchOptions GetNativeSearchOptions(SearchProviderOptions searchOptions) {
       var options = NativeMethods.SearchOptions.kNone;
       if (searchOptions.MatchCase) {
         options |= NativeMethods.SearchOptions.kMatchCase;
@@ -28,23 +158,23 @@ namespace VsChromium.Server.FileSystemContents {
       if (searchOptions.MatchWholeWord) {
         options |= NativeMethods.SearchOptions.kMatchWholeWord;
       }
-
-      if (searchOptions.UseRegex && searchOptions.UseRe2Engine)
-        return new AsciiCompiledTextSearchRe2(pattern, options);
-
-      if (searchOptions.UseRegex)
-        return new AsciiCompiledTextSearchRegex(pattern, options);
-
-      if (pattern.Length <= 64)
-        return new AsciiCompiledTextSearchBndm64(pattern, options);
-
-      return new AsciiCompiledTextSearchBoyerMoore(pattern, options);
+      return options;
     }
 
     public override byte CharacterSize {
       get { return sizeof(byte); }
     }
 
+    protected override IList<TextRange> FindAllWithWildcardSearch(
+      CompiledTextSearchData compiledTextSearchData,
+      TextFragment textFragment,
+      IOperationProgressTracker progressTracker) {
+      var wildcardSearch = compiledTextSearchData.AsciiWildcardSearch;
+      if (wildcardSearch == null)
+        return null;
+      return wildcardSearch.FindAll(textFragment, TextFragment, progressTracker);
+    }
+
     protected override ICompiledTextSearch GetCompiledTextSearch(ICompiledTextSearchContainer container) {
       return container.GetAsciiSearch();
     }
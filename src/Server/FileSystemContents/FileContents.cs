@@ -52,6 +52,10 @@ namespace VsChromium.Server.FileSystemContents {
       IOperationProgressTracker progressTracker) {
 
       var textFragment = CreateFragmentFromRange(textRange);
+      var wildcardResult = FindAllWithWildcardSearch(compiledTextSearchData, textFragment, progressTracker);
+      if (wildcardResult != null)
+        return wildcardResult;
+
       var providerForMainEntry = compiledTextSearchData
         .GetSearchContainer(compiledTextSearchData.ParsedSearchString.LongestEntry);
       var textSearch = GetCompiledTextSearch(providerForMainEntry);
@@ -81,13 +85,27 @@ namespace VsChromium.Server.FileSystemContents {
 
     protected abstract ICompiledTextSearch GetCompiledTextSearch(ICompiledTextSearchContainer container);
 
+    /// <summary>
+    /// Find all instances of a search string containing wildcards with a
+    /// search algorithm matching all the entries at once, or return
+    /// <code>null</code> if no such algorithm is available, in which case
+    /// the longest entry is searched first and the other entries are matched
+    /// with <see cref="TextSourceTextSearch"/>.
+    /// </summary>
+    protected virtual IList<TextRange> FindAllWithWildcardSearch(
+      CompiledTextSearchData compiledTextSearchData,
+      TextFragment textFragment,
+      IOperationProgressTracker progressTracker) {
+      return null;
+    }
+
     protected abstract TextRange GetLineTextRangeFromPosition(int position, int maxRangeLength);
 
     protected FileContentsMemory Contents {
       get { return _contents; }
     }
 
-    private TextFragment CreateFragmentFromRange(TextRange textRange) {
+    protected TextFragment CreateFragmentFromRange(TextRange textRange) {
       return TextFragment.Sub(textRange.Position, textRange.Length);
     }
 
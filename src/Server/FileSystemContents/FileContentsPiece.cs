@@ -34,6 +34,11 @@ namespace VsChromium.Server.FileSystemContents {
 
     public FileContents FileContents => _fileContents;
 
+    /// <summary>
+    /// The range of text of <see cref="FileContents"/> covered by this piece.
+    /// </summary>
+    public TextRange TextRange => _textRange;
+
     /// <summary>
     /// A unique identifier of the file this piece is part of. This ID is
     /// redundant with <see cref="FileName"/>, it is only needed for
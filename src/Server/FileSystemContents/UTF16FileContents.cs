@@ -48,7 +48,7 @@ namespace VsChromium.Server.FileSystemContents {
       if (searchOptions.MatchWholeWord) {
         options |= NativeMethods.SearchOptions.kMatchWholeWord;
       }
-      return new Utf16CompiledTextSearchStdSearch(pattern, options);
+      return new Utf16CompiledTextSearchNative(NativeMethods.SearchAlgorithmKind.kUtf16SimdLiteral, pattern, options);
     }
   }
 }
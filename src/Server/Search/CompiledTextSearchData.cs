@@ -5,6 +5,7 @@
 using System;
 using System.Collections.Generic;
 using VsChromium.Server.FileSystemNames;
+using VsChromium.Server.NativeInterop;
 
 namespace VsChromium.Server.Search {
   /// <summary>
@@ -15,14 +16,17 @@ namespace VsChromium.Server.Search {
     private readonly ParsedSearchString _parsedSearchString;
     private readonly IList<ICompiledTextSearchContainer> _searchContainers;
     private readonly Func<FileName, bool> _fileNameFilter;
+    private readonly AsciiCompiledTextSearchWildcard _asciiWildcardSearch;
 
     public CompiledTextSearchData(
       ParsedSearchString parsedSearchString,
       IList<ICompiledTextSearchContainer> searchContainers,
-      Func<FileName, bool> fileNameFilter) {
+      Func<FileName, bool> fileNameFilter,
+      AsciiCompiledTextSearchWildcard asciiWildcardSearch = null) {
       _parsedSearchString = parsedSearchString;
       _searchContainers = searchContainers;
       _fileNameFilter = fileNameFilter;
+      _asciiWildcardSearch = asciiWildcardSearch;
     }
 
     /// <summary>
@@ -43,6 +47,15 @@ namespace VsChromium.Server.Search {
       get { return _fileNameFilter; }
     }
 
+    /// <summary>
+    /// The native search for all the entries of <see
+    /// cref="ParsedSearchString"/> in ASCII files, or <code>null</code> if the
+    /// search string contains a single entry.
+    /// </summary>
+    public AsciiCompiledTextSearchWildcard AsciiWildcardSearch {
+      get { return _asciiWildcardSearch; }
+    }
+
     /// <summary>
     /// Retrieve the <see cref="ICompiledTextSearchContainer"/> for a given
     /// search entry.
@@ -59,6 +72,9 @@ namespace VsChromium.Server.Search {
       foreach (var provider in _searchContainers) {
         provider.Dispose();
       }
+      if (_asciiWildcardSearch != null) {
+        _asciiWildcardSearch.Dispose();
+      }
     }
   }
 }
@@ -8,12 +8,14 @@ using System.ComponentModel.Composition;
 using System.Linq;
 using VsChromium.Core.Ipc;
 using VsChromium.Core.Ipc.TypedMessages;
+using VsChromium.Server.FileSystemContents;
 using VsChromium.Server.FileSystemNames;
 
 namespace VsChromium.Server.Search {
   [Export(typeof(ICompiledTextSearchDataFactory))]
   public class CompiledTextSearchDataFactory : ICompiledTextSearchDataFactory {
     private const int MinimumSearchPatternLength = 2;
+    private const string RegexSpecialCharacters = @"\^$.|?*+()[]{}";
     private readonly ISearchStringParser _searchStringParser;
     private readonly ICompiledTextSearchProviderFactory _compiledTextSearchProviderFactory;
 
@@ -43,29 +45,66 @@ namespace VsChromium.Server.Search {
         parsedSearchString = _searchStringParser.Parse(searchParams.SearchString ?? "", SearchStringParserOptions.SupportsAsterisk);
       }
 
+      var searchProviderOptions = new SearchProviderOptions {
+        MatchCase = searchParams.MatchCase,
+        MatchWholeWord = searchParams.MatchWholeWord,
+        UseRegex = searchParams.Regex,
+        UseRe2Engine = searchParams.UseRe2Engine,
+        UseMultiLiteral = searchParams.Regex && IsLiteralAlternation(searchParams.SearchString),
+        // Patterns with wildcards are matched exactly.
+        MaxErrors = (searchParams.Regex ||
+                     parsedSearchString.EntriesBeforeLongestEntry.Count > 0 ||
+                     parsedSearchString.EntriesAfterLongestEntry.Count > 0) ? 0 : searchParams.MaxErrors,
+      };
       var searchContentsAlgorithms = CreateSearchAlgorithms(
         parsedSearchString,
-        new SearchProviderOptions {
-          MatchCase = searchParams.MatchCase,
-          MatchWholeWord = searchParams.MatchWholeWord,
-          UseRegex = searchParams.Regex,
-          UseRe2Engine = searchParams.UseRe2Engine
-        });
+        searchProviderOptions);
+
+      // Entries around the longest entry are matched natively in ASCII files.
+      var asciiWildcardSearch = (parsedSearchString.EntriesBeforeLongestEntry.Count > 0 ||
+                                 parsedSearchString.EntriesAfterLongestEntry.Count > 0)
+        ? AsciiFileContents.CreateWildcardSearchAlgo(
+            GetAllEntries(parsedSearchString).Select(x => x.Text),
+            searchProviderOptions)
+        : null;
 
       return new CompiledTextSearchData(
         parsedSearchString,
         searchContentsAlgorithms,
-        fileNamePathMatcher);
+        fileNamePathMatcher,
+        asciiWildcardSearch);
+    }
+
+    /// <summary>
+    /// Returns <code>true</code> if <paramref name="pattern"/> is a regular
+    /// expression of the form "foo|bar|blah", i.e. an alternation of non empty
+    /// literals, which can be searched without a regular expression engine.
+    /// </summary>
+    private static bool IsLiteralAlternation(string pattern) {
+      if (string.IsNullOrEmpty(pattern))
+        return false;
+
+      var alternatives = pattern.Split('|');
+      if (alternatives.Length < 2)
+        return false;
+
+      return alternatives.All(x =>
+        x.Length > 0 &&
+        x.All(c => c < 0x80 && !char.IsControl(c) && RegexSpecialCharacters.IndexOf(c) < 0));
     }
 
     private List<ICompiledTextSearchContainer> CreateSearchAlgorithms(
       ParsedSearchString parsedSearchString, SearchProviderOptions options) {
+      return GetAllEntries(parsedSearchString)
+        .Select(entry => _compiledTextSearchProviderFactory.CreateProvider(entry.Text, options))
+        .ToList();
+    }
+
+    private static IEnumerable<ParsedSearchString.Entry> GetAllEntries(ParsedSearchString parsedSearchString) {
       return parsedSearchString.EntriesBeforeLongestEntry
         .Concat(new[] { parsedSearchString.LongestEntry })
         .Concat(parsedSearchString.EntriesAfterLongestEntry)
-        .OrderBy(x => x.Index)
-        .Select(entry => _compiledTextSearchProviderFactory.CreateProvider(entry.Text, options))
-        .ToList();
+        .OrderBy(x => x.Index);
     }
   }
 }
\ No newline at end of file
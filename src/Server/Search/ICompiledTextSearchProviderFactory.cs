@@ -12,5 +12,15 @@ namespace VsChromium.Server.Search {
     public bool MatchWholeWord { get; set; }
     public bool UseRegex { get; set; }
     public bool UseRe2Engine { get; set; }
+    /// <summary>
+    /// The pattern is a list of literals separated by '|', to be searched
+    /// with the native multi-pattern literal algorithm.
+    /// </summary>
+    public bool UseMultiLiteral { get; set; }
+    /// <summary>
+    /// The number of errors allowed in the matches of approximate searches,
+    /// or 0 for exact searches.
+    /// </summary>
+    public int MaxErrors { get; set; }
   }
 }
\ No newline at end of file
@@ -27,5 +27,9 @@ namespace VsChromium.Server.Search {
     public TextRange? FindFirst(TextFragment textFragment, IOperationProgressTracker progressTracker) {
       return null;
     }
+
+    public int Count(TextFragment textFragment, int maxCount) {
+      return 0;
+    }
   }
 }
\ No newline at end of file
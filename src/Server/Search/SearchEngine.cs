@@ -31,6 +31,11 @@ namespace VsChromium.Server.Search {
     private static readonly TaskId UpdateFileContentsTaskId = new TaskId("UpdateFileContentsTaskId");
     private static readonly TaskId ComputeNewStatedId = new TaskId("ComputeNewStateId");
     private static readonly TaskId GarbageCollectId = new TaskId("GarbageCollectId");
+    /// <summary>
+    /// The number of consecutive <see cref="FileContentsPiece"/> searched by
+    /// a single task during a code search.
+    /// </summary>
+    private const int PieceBatchSize = 64;
     private readonly IFileDatabaseSnapshotFactory _fileDatabaseSnapshotFactory;
     private readonly IFileSystemNameFactory _fileSystemNameFactory;
     private readonly IProjectDiscovery _projectDiscovery;
@@ -84,6 +89,10 @@ namespace VsChromium.Server.Search {
       // Create a "Null" state
       _currentFileDatabase = _fileDatabaseSnapshotFactory.CreateEmpty();
 
+      // The native search algorithms pick their implementation variant
+      // (AVX2, SSE4.2, etc.) according to the CPU features available.
+      Logger.LogInfo("Native search algorithms CPU features: {0}", NativeMethods.Native_GetCpuFeatures());
+
       // Setup computing a new state everytime a new tree is computed.
       fileSystemSnapshotManager.SnapshotScanFinished += FileSystemSnapshotManagerOnSnapshotScanFinished;
       fileSystemSnapshotManager.FilesChanged += FileSystemSnapshotManagerOnFilesChanged;
@@ -174,50 +183,110 @@ namespace VsChromium.Server.Search {
       int maxResults,
       bool includeSymLinks,
       CancellationToken cancellationToken) {
-      var progressTracker = new OperationProgressTracker(maxResults, cancellationToken);
-      var searchedFileIds = new PartitionedBitArray(
-        _currentFileDatabase.SearchableFileCount,
-        Environment.ProcessorCount * 2);
-      var matches = _currentFileDatabase.FileContentsPieces
-        .AsParallel()
-        .WithExecutionMode(ParallelExecutionMode.ForceParallelism)
-        .WithCancellation(cancellationToken)
-        .Where(x => !progressTracker.ShouldEndProcessing)
-        .Select(item => {
-          // Filter out files inside symlinks if needed
-          if (!includeSymLinks) {
-            if (_currentFileDatabase.IsContainedInSymLink(item.FileName))
-              return default(SearchableContentsResult);
-          }
-          // Filter out files that don't match the file name match pattern
-          if (!compiledTextSearchData.FileNameFilter(item.FileName)) {
-            return default(SearchableContentsResult);
-          }
-          searchedFileIds.Set(item.FileId, true);
-          return new SearchableContentsResult {
-            FileContentsPiece = item,
-            Spans = item
-              .FindAll(compiledTextSearchData, progressTracker)
-              .Select(x => new FilePositionSpan {
-                Position = x.Position,
-                Length = x.Length,
-              })
-              .ToList(),
-          };
-        })
-        .Where(r => r.Spans != null && r.Spans.Count > 0)
-        .GroupBy(r => r.FileContentsPiece.FileId)
-        .Select(g => new FileSearchResult {
-          FileName = g.First().FileContentsPiece.FileName,
-          Spans = g.OrderBy(x => x.Spans.First().Position).SelectMany(x => x.Spans).ToList()
-        })
-        .ToList();
+      // Disposed once all the native searches of the operation are done.
+      using (var progressTracker = new OperationProgressTracker(maxResults, cancellationToken)) {
+        var searchedFileIds = new PartitionedBitArray(
+          _currentFileDatabase.SearchableFileCount,
+          Environment.ProcessorCount * 2);
+        // Pieces are searched in batches, so that the many small files of a
+        // typical source tree are searched with a single native call per batch.
+        var pieces = _currentFileDatabase.FileContentsPieces;
+        var matches = Enumerable.Range(0, (pieces.Count + PieceBatchSize - 1) / PieceBatchSize)
+          .AsParallel()
+          .WithExecutionMode(ParallelExecutionMode.ForceParallelism)
+          .WithCancellation(cancellationToken)
+          .Where(x => !progressTracker.ShouldEndProcessing)
+          .SelectMany(batchIndex => {
+            var start = batchIndex * PieceBatchSize;
+            var count = Math.Min(PieceBatchSize, pieces.Count - start);
+            return SearchPieces(
+              compiledTextSearchData,
+              pieces,
+              start,
+              count,
+              includeSymLinks,
+              searchedFileIds,
+              progressTracker);
+          })
+          .Where(r => r.Spans != null && r.Spans.Count > 0)
+          .GroupBy(r => r.FileContentsPiece.FileId)
+          .Select(g => new FileSearchResult {
+            FileName = g.First().FileContentsPiece.FileName,
+            Spans = g.OrderBy(x => x.Spans.First().Position).SelectMany(x => x.Spans).ToList()
+          })
+          .ToList();
+
+        return new SearchCodeResult {
+          Entries = matches,
+          SearchedFileCount = searchedFileIds.Count,
+          TotalFileCount = _currentFileDatabase.SearchableFileCount,
+          HitCount = progressTracker.ResultCount,
+        };
+      }
+    }
+
+    private List<SearchableContentsResult> SearchPieces(
+      CompiledTextSearchData compiledTextSearchData,
+      IList<FileContentsPiece> pieces,
+      int start,
+      int count,
+      bool includeSymLinks,
+      PartitionedBitArray searchedFileIds,
+      IOperationProgressTracker progressTracker) {
+      var asciiPieces = new List<FileContentsPiece>();
+      var otherPieces = new List<FileContentsPiece>();
+      for (var i = start; i < start + count; i++) {
+        var item = pieces[i];
+        // Filter out files inside symlinks if needed
+        if (!includeSymLinks) {
+          if (_currentFileDatabase.IsContainedInSymLink(item.FileName))
+            continue;
+        }
+        // Filter out files that don't match the file name match pattern
+        if (!compiledTextSearchData.FileNameFilter(item.FileName)) {
+          continue;
+        }
+        searchedFileIds.Set(item.FileId, true);
+        if (item.FileContents is AsciiFileContents) {
+          asciiPieces.Add(item);
+        } else {
+          otherPieces.Add(item);
+        }
+      }
+
+      var result = new List<SearchableContentsResult>();
+      var asciiMatches = asciiPieces.Count > 1
+        ? AsciiFileContents.FindAllInPieces(compiledTextSearchData, asciiPieces, progressTracker)
+        : null;
+      if (asciiMatches == null) {
+        otherPieces.AddRange(asciiPieces);
+      } else {
+        for (var i = 0; i < asciiPieces.Count; i++) {
+          result.Add(CreateSearchableContentsResult(asciiPieces[i], asciiMatches[i]));
+        }
+      }
+
+      foreach (var item in otherPieces) {
+        if (progressTracker.ShouldEndProcessing)
+          break;
+        result.Add(CreateSearchableContentsResult(
+          item,
+          item.FindAll(compiledTextSearchData, progressTracker)));
+      }
+      return result;
+    }
 
-      return new SearchCodeResult {
-        Entries = matches,
-        SearchedFileCount = searchedFileIds.Count,
-        TotalFileCount = _currentFileDatabase.SearchableFileCount,
-        HitCount = progressTracker.ResultCount,
+    private static SearchableContentsResult CreateSearchableContentsResult(
+      FileContentsPiece piece,
+      IList<TextRange> matches) {
+      return new SearchableContentsResult {
+        FileContentsPiece = piece,
+        Spans = matches
+          .Select(x => new FilePositionSpan {
+            Position = x.Position,
+            Length = x.Length,
+          })
+          .ToList(),
       };
     }
 
@@ -454,9 +523,9 @@ namespace VsChromium.Server.Search {
         try {
           var range = new TextFragment(ptr, 0, value.Length, sizeof(byte));
 
-          var hit = _searchContainer.GetAsciiSearch()
-            .FindFirst(range, OperationProgressTracker.None);
-          if (hit.HasValue)
+          // Only the existence of a match matters, not its position.
+          var hitCount = _searchContainer.GetAsciiSearch().Count(range, 1);
+          if (hitCount > 0)
             return true;
 
           if (!hasDirectorySeparators)
@@ -472,9 +541,8 @@ namespace VsChromium.Server.Search {
           }
 
           // Search again
-          hit = _searchContainer.GetAsciiSearch()
-            .FindFirst(range, OperationProgressTracker.None);
-          return hit.HasValue;
+          hitCount = _searchContainer.GetAsciiSearch().Count(range, 1);
+          return hitCount > 0;
         } finally {
           Marshal.FreeHGlobal(ptr);
         }
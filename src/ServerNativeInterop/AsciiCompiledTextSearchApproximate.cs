@@ -0,0 +1,22 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Approximate search, matching the pattern with up to a given number of
+  /// errors (inserted, deleted or substituted characters), e.g. to find
+  /// misspelled identifiers in a single pass over the text.
+  /// </summary>
+  public class AsciiCompiledTextSearchApproximate : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchApproximate(string pattern, int maxErrors, NativeMethods.SearchOptions searchOptions)
+      : base(NativeMethods.SearchAlgorithmKind.kApproximate, pattern, GetSearchOptions(maxErrors, searchOptions)) {
+    }
+
+    private static NativeMethods.SearchOptions GetSearchOptions(int maxErrors, NativeMethods.SearchOptions searchOptions) {
+      var errors = (NativeMethods.SearchOptions)(maxErrors << NativeMethods.SearchOptionsMaxErrorsShift);
+      return (searchOptions & ~NativeMethods.SearchOptions.kMaxErrorsMask) |
+             (errors & NativeMethods.SearchOptions.kMaxErrorsMask);
+    }
+  }
+}
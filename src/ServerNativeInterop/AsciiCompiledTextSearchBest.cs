@@ -0,0 +1,62 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using System.Runtime.InteropServices;
+using VsChromium.Core.Win32.Memory;
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Literal search using the native algorithm that is the fastest for the
+  /// pattern on a sample of the files loaded so far. Patterns of common
+  /// characters (e.g. "ee") do not favor the same algorithms as patterns of
+  /// rare characters (e.g. "xyz"), whatever their length.
+  /// </summary>
+  public class AsciiCompiledTextSearchBest : AsciiCompiledTextSearchNative {
+    private readonly NativeMethods.SearchAlgorithmChoice _choice;
+
+    private AsciiCompiledTextSearchBest(
+        SafeHGlobalHandle patternHandle,
+        SafeSearchHandle handle,
+        NativeMethods.SearchAlgorithmChoice choice)
+      : base(patternHandle, handle) {
+      _choice = choice;
+    }
+
+    public static AsciiCompiledTextSearchBest Create(string pattern, NativeMethods.SearchOptions searchOptions) {
+      var patternHandle = new SafeHGlobalHandle(Marshal.StringToHGlobalAnsi(pattern));
+      NativeMethods.SearchCreateResult createResult;
+      NativeMethods.SearchAlgorithmChoice choice;
+      var handle = NativeMethods.AsciiSearchAlgorithm_CreateBest(
+          patternHandle.Pointer,
+          pattern.Length,
+          searchOptions,
+          out createResult,
+          out choice);
+      CheckCreateResult(ref createResult);
+      return new AsciiCompiledTextSearchBest(patternHandle, handle, choice);
+    }
+
+    /// <summary>
+    /// The native algorithm selected for the pattern.
+    /// </summary>
+    public NativeMethods.SearchAlgorithmKind Kind {
+      get { return _choice.Kind; }
+    }
+
+    /// <summary>
+    /// The number of bytes of the sample the algorithms were timed on.
+    /// </summary>
+    public int SampleLength {
+      get { return _choice.SampleLength; }
+    }
+
+    /// <summary>
+    /// The throughput of the selected algorithm on the sample, or 0 if no
+    /// file has been loaded yet.
+    /// </summary>
+    public double BytesPerSecond {
+      get { return _choice.BytesPerSecond; }
+    }
+  }
+}
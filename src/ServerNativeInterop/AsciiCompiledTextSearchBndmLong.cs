@@ -0,0 +1,16 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// BNDM search without limit on the pattern length: BNDM is run on a 64
+  /// character window of the pattern, and each hit is verified against the
+  /// whole pattern.
+  /// </summary>
+  public class AsciiCompiledTextSearchBndmLong : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchBndmLong(string pattern, NativeMethods.SearchOptions searchOptions)
+      : base(NativeMethods.SearchAlgorithmKind.kBndmLong, pattern, searchOptions) {
+    }
+  }
+}
@@ -0,0 +1,18 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using System.Collections.Generic;
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Searches for any of a list of literal patterns in a single pass over the
+  /// text. The patterns are passed to the native code separated by a new line
+  /// character.
+  /// </summary>
+  public class AsciiCompiledTextSearchMultiLiteral : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchMultiLiteral(IEnumerable<string> patterns, NativeMethods.SearchOptions searchOptions)
+      : base(NativeMethods.SearchAlgorithmKind.kMultiLiteral, string.Join("\n", patterns), searchOptions) {
+    }
+  }
+}
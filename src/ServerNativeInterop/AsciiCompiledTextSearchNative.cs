@@ -3,8 +3,10 @@
 // found in the LICENSE file.
 
 using System;
+using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using VsChromium.Core.Ipc;
+using VsChromium.Core.Utility;
 using VsChromium.Core.Win32.Memory;
 using VsChromium.Core.Win32.Strings;
 
@@ -25,7 +27,19 @@ namespace VsChromium.Server.NativeInterop {
       _searchBufferSize = NativeMethods.AsciiSearchAlgorithm_GetSearchBufferSize(_handle);
     }
 
-    private static unsafe SafeSearchHandle CreateSearchHandle(
+    /// <summary>
+    /// Used by derived classes creating <paramref name="handle"/> with an
+    /// other function than <see
+    /// cref="NativeMethods.AsciiSearchAlgorithm_Create"/>. <paramref
+    /// name="patternHandle"/> must outlive the search algorithm.
+    /// </summary>
+    protected AsciiCompiledTextSearchNative(SafeHGlobalHandle patternHandle, SafeSearchHandle handle) {
+      _patternHandle = patternHandle;
+      _handle = handle;
+      _searchBufferSize = NativeMethods.AsciiSearchAlgorithm_GetSearchBufferSize(_handle);
+    }
+
+    protected static unsafe SafeSearchHandle CreateSearchHandle(
         NativeMethods.SearchAlgorithmKind kind,
         SafeHGlobalHandle patternHandle,
         int patternLength,
@@ -37,15 +51,27 @@ namespace VsChromium.Server.NativeInterop {
           patternLength,
           searchOptions,
           out createResult);
+      CheckCreateResult(ref createResult);
+      return result;
+    }
 
+    protected static unsafe void CheckCreateResult(ref NativeMethods.SearchCreateResult createResult) {
       if (createResult.HResult < 0) {
         // The error is recoverable, since we are dealing with an invalid pattern
         // or something along the lines.
-        var message = Marshal.PtrToStringAnsi(new IntPtr(createResult.ErrorMessage));
-        throw new RecoverableErrorException(message);
+        fixed (byte* errorMessage = createResult.ErrorMessage) {
+          var message = Marshal.PtrToStringAnsi(new IntPtr(errorMessage));
+          throw new RecoverableErrorException(message);
+        }
       }
+    }
 
-      return result;
+    /// <summary>
+    /// The native search algorithm, e.g. for <see
+    /// cref="AsciiStreamingTextSearch"/>.
+    /// </summary>
+    internal SafeSearchHandle Handle {
+      get { return _handle; }
     }
 
     protected override int SearchBufferSize {
@@ -56,6 +82,100 @@ namespace VsChromium.Server.NativeInterop {
       NativeMethods.AsciiSearchAlgorithm_Search(_handle, ref searchParams);
     }
 
+    protected override unsafe int SearchMatches(
+        ref NativeMethods.SearchParams searchParams,
+        NativeMethods.SearchMatch* matches,
+        int capacity) {
+      int matchCount;
+      NativeMethods.AsciiSearchAlgorithm_FindAll(
+          _handle, ref searchParams, new IntPtr(matches), capacity, out matchCount);
+      return matchCount;
+    }
+
+    /// <summary>
+    /// Find all occurrences of the search pattern in each of <paramref
+    /// name="textFragments"/>, using a single native call per batch of
+    /// matches instead of (at least) one native call per fragment. The
+    /// returned array contains the matches of each fragment, in the same
+    /// order as <paramref name="textFragments"/>. The 64-bit exports are
+    /// used, so that the fragments and matches are passed without
+    /// conversion.
+    /// </summary>
+    public unsafe IList<TextRange>[] FindAllFragments(
+        IList<TextFragment> textFragments,
+        IOperationProgressTracker progressTracker) {
+      var result = new IList<TextRange>[textFragments.Count];
+      var fragments = new NativeMethods.SearchFragment64[textFragments.Count];
+      for (var i = 0; i < textFragments.Count; i++) {
+        fragments[i].TextStart = textFragments[i].StartPtr;
+        fragments[i].TextLength = textFragments[i].Length;
+      }
+
+      // Note: From C# spec: If E is zero, then no allocation is made, and
+      // the pointer returned is implementation-defined.
+      byte* searchBuffer = stackalloc byte[this.SearchBufferSize];
+      var matches = stackalloc NativeMethods.SearchFragmentMatch64[MatchBatchSize];
+      var searchParams = new NativeMethods.SearchParams64 {
+        SearchBuffer = new IntPtr(searchBuffer),
+        Cancelled = progressTracker.CancelledFlag,
+      };
+      var fragmentIndex = 0;
+
+      fixed (NativeMethods.SearchFragment64* fragmentsPtr = fragments) {
+        while (true) {
+          int matchCount;
+          NativeMethods.AsciiSearchAlgorithm_FindAllFragments64(
+              _handle,
+              new IntPtr(fragmentsPtr),
+              fragments.Length,
+              ref fragmentIndex,
+              ref searchParams,
+              new IntPtr(matches),
+              MatchBatchSize,
+              out matchCount);
+
+          var endProcessing = false;
+          for (var i = 0; i < matchCount; i++) {
+            var index = matches[i].FragmentIndex;
+            if (result[index] == null)
+              result[index] = new List<TextRange>();
+            result[index].Add(new TextRange(textFragments[index].Position + (int)matches[i].Offset, (int)matches[i].Length));
+
+            // Check it is time to end processing early.
+            progressTracker.AddResults(1);
+            if (progressTracker.ShouldEndProcessing) {
+              endProcessing = true;
+              break;
+            }
+          }
+
+          if (endProcessing) {
+            // The search may have reached the end of the last fragment of
+            // the batch already.
+            if (searchParams.MatchStart != IntPtr.Zero)
+              NativeMethods.AsciiSearchAlgorithm_CancelSearch64(_handle, ref searchParams);
+            break;
+          }
+
+          // All fragments have been searched
+          if (matchCount < MatchBatchSize)
+            break;
+        }
+      }
+
+      for (var i = 0; i < result.Length; i++) {
+        if (result[i] == null)
+          result[i] = NoResult;
+      }
+      return result;
+    }
+
+    protected override int Count(ref NativeMethods.SearchParams searchParams, int maxCount) {
+      int matchCount;
+      NativeMethods.AsciiSearchAlgorithm_Count(_handle, ref searchParams, maxCount, out matchCount);
+      return matchCount;
+    }
+
     protected override void CancelSearch(ref NativeMethods.SearchParams searchParams) {
       NativeMethods.AsciiSearchAlgorithm_CancelSearch(_handle, ref searchParams);
     }
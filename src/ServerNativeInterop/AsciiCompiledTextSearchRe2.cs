@@ -2,10 +2,28 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+using System;
+using System.Collections.Generic;
+using System.Text;
+
 namespace VsChromium.Server.NativeInterop {
   public class AsciiCompiledTextSearchRe2 : AsciiCompiledTextSearchNative {
     public AsciiCompiledTextSearchRe2(string pattern, NativeMethods.SearchOptions searchOptions)
       : base(NativeMethods.SearchAlgorithmKind.kRe2, pattern, searchOptions) {
     }
+
+    /// <summary>
+    /// The literal strings, in lower case, one of which is part of every
+    /// match. The text is searched for them before running RE2 on the lines
+    /// containing them. Empty if RE2 runs on the whole text.
+    /// </summary>
+    public IList<string> PrefilterAtoms {
+      get {
+        var length = NativeMethods.RE2Search_GetPrefilterAtoms(Handle, null, 0);
+        var buffer = new StringBuilder(length + 1);
+        NativeMethods.RE2Search_GetPrefilterAtoms(Handle, buffer, buffer.Capacity);
+        return buffer.ToString().Split(new[] { '\n' }, StringSplitOptions.RemoveEmptyEntries);
+      }
+    }
   }
 }
\ No newline at end of file
@@ -7,5 +7,13 @@ namespace VsChromium.Server.NativeInterop {
     public AsciiCompiledTextSearchRegex(string pattern, NativeMethods.SearchOptions searchOptions)
       : base(NativeMethods.SearchAlgorithmKind.kRegex, pattern, searchOptions) {
     }
+
+    /// <summary>
+    /// The engine the pattern is searched with: std::regex backtracks, so
+    /// it only runs the patterns RE2 cannot search the same way.
+    /// </summary>
+    public NativeMethods.RegexEngine Engine {
+      get { return NativeMethods.RegexSearch_GetEngine(Handle); }
+    }
   }
 }
\ No newline at end of file
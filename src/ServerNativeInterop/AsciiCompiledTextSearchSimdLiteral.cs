@@ -0,0 +1,11 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+namespace VsChromium.Server.NativeInterop {
+  public class AsciiCompiledTextSearchSimdLiteral : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchSimdLiteral(string pattern, NativeMethods.SearchOptions searchOptions)
+      : base(NativeMethods.SearchAlgorithmKind.kSimdLiteral, pattern, searchOptions) {
+    }
+  }
+}
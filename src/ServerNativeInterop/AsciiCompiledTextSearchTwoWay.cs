@@ -0,0 +1,16 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Two-Way (Crochemore-Perrin) search, which runs in linear time whatever
+  /// the pattern. Used for periodic patterns (e.g. "========"), which make
+  /// the other algorithms quadratic on repetitive text.
+  /// </summary>
+  public class AsciiCompiledTextSearchTwoWay : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchTwoWay(string pattern, NativeMethods.SearchOptions searchOptions)
+      : base(NativeMethods.SearchAlgorithmKind.kTwoWay, pattern, searchOptions) {
+    }
+  }
+}
@@ -0,0 +1,35 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using System.Runtime.InteropServices;
+using System.Text;
+using VsChromium.Core.Win32.Memory;
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Case insensitive search using Unicode case folding, for patterns
+  /// containing non ASCII characters: UTF-8 files are loaded as ASCII files,
+  /// whose case insensitive search only folds 'A' to 'Z'. The pattern is
+  /// passed to the native code in UTF-8, the encoding of the file contents.
+  /// </summary>
+  public class AsciiCompiledTextSearchUtf8CaseFolding : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchUtf8CaseFolding(string pattern, NativeMethods.SearchOptions searchOptions)
+      : this(CreatePatternHandle(pattern), Encoding.UTF8.GetByteCount(pattern), searchOptions) {
+    }
+
+    private AsciiCompiledTextSearchUtf8CaseFolding(
+        SafeHGlobalHandle patternHandle,
+        int patternLength,
+        NativeMethods.SearchOptions searchOptions)
+      : base(patternHandle, CreateSearchHandle(NativeMethods.SearchAlgorithmKind.kUtf8CaseFolding, patternHandle, patternLength, searchOptions)) {
+    }
+
+    private static SafeHGlobalHandle CreatePatternHandle(string pattern) {
+      var bytes = Encoding.UTF8.GetBytes(pattern + '\0');
+      var handle = new SafeHGlobalHandle(Marshal.AllocHGlobal(bytes.Length));
+      Marshal.Copy(bytes, 0, handle.Pointer, bytes.Length);
+      return handle;
+    }
+  }
+}
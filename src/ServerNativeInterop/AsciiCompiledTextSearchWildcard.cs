@@ -0,0 +1,32 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using System.Collections.Generic;
+using VsChromium.Core.Utility;
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Searches for a list of entries appearing in order on the same line (i.e.
+  /// "foo*bar" search strings). Only the matches spanning all the entries are
+  /// returned.
+  /// </summary>
+  public class AsciiCompiledTextSearchWildcard : AsciiCompiledTextSearchNative {
+    public AsciiCompiledTextSearchWildcard(IEnumerable<string> entries, NativeMethods.SearchOptions searchOptions)
+      : base(NativeMethods.SearchAlgorithmKind.kWildcard, string.Join("\n", entries), searchOptions) {
+    }
+
+    /// <summary>
+    /// Find all matches within <paramref name="textFragment"/>. The extent of
+    /// lines is computed from <paramref name="fileFragment"/>, so that lines
+    /// crossing the boundaries of <paramref name="textFragment"/> are taken
+    /// into account.
+    /// </summary>
+    public IList<TextRange> FindAll(
+      TextFragment textFragment,
+      TextFragment fileFragment,
+      IOperationProgressTracker progressTracker) {
+      return FindAllInContext(textFragment, fileFragment, progressTracker);
+    }
+  }
+}
@@ -0,0 +1,82 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using System;
+using System.Collections.Generic;
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Searches a text fed one chunk at a time, e.g. a large file read one
+  /// window at a time, so that the whole text never needs to be in memory.
+  /// Matches spanning chunk boundaries are found, as long as they are not
+  /// longer than the maximum match length passed to the constructor. For
+  /// wildcard searches, whose entries are found anywhere on the line of the
+  /// longest entry, the maximum match length is the length of the longest
+  /// entry.
+  /// </summary>
+  public class AsciiStreamingTextSearch : IDisposable {
+    private const int MatchBatchSize = 256;
+    // Referenced by the native streaming search.
+    private readonly AsciiCompiledTextSearchNative _search;
+    private readonly SafeStreamingSearchHandle _handle;
+
+    /// <summary>
+    /// <paramref name="search"/> must outlive this instance, and must be
+    /// created without <see cref="NativeMethods.SearchOptions.kMatchWholeWord"/>:
+    /// pass it in <paramref name="searchOptions"/> instead, so that whole
+    /// word matching is checked across chunk boundaries. Wildcard searches,
+    /// which match whole words in their entries, are the exception: they are
+    /// created with it, and <paramref name="searchOptions"/> does not have it.
+    /// </summary>
+    public AsciiStreamingTextSearch(
+        AsciiCompiledTextSearchNative search,
+        NativeMethods.SearchOptions searchOptions,
+        long maxMatchLength) {
+      _search = search;
+      _handle = NativeMethods.StreamingSearch_Create(search.Handle, searchOptions, maxMatchLength);
+    }
+
+    /// <summary>
+    /// Searches the <paramref name="length"/> bytes at <paramref
+    /// name="chunk"/>, which follow the chunks fed so far, and returns the
+    /// matches that no further chunk can change, with offsets relative to
+    /// the start of the text. <paramref name="chunk"/> does not need to
+    /// outlive the call.
+    /// </summary>
+    public IList<NativeMethods.SearchMatch64> FeedChunk(IntPtr chunk, long length) {
+      int matchCount;
+      NativeMethods.StreamingSearch_FeedChunk(_handle, chunk, length, out matchCount);
+      return FetchMatches(matchCount);
+    }
+
+    /// <summary>
+    /// Returns the matches at the end of the text. The next chunk fed starts
+    /// a new text.
+    /// </summary>
+    public IList<NativeMethods.SearchMatch64> Finish() {
+      int matchCount;
+      NativeMethods.StreamingSearch_Finish(_handle, out matchCount);
+      return FetchMatches(matchCount);
+    }
+
+    private unsafe IList<NativeMethods.SearchMatch64> FetchMatches(int matchCount) {
+      var result = new List<NativeMethods.SearchMatch64>(matchCount);
+      var matches = stackalloc NativeMethods.SearchMatch64[MatchBatchSize];
+      while (result.Count < matchCount) {
+        int count;
+        NativeMethods.StreamingSearch_FetchMatches(_handle, new IntPtr(matches), MatchBatchSize, out count);
+        if (count == 0)
+          break;
+        for (var i = 0; i < count; i++) {
+          result.Add(matches[i]);
+        }
+      }
+      return result;
+    }
+
+    public void Dispose() {
+      _handle.Dispose();
+    }
+  }
+}
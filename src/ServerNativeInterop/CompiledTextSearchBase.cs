@@ -6,10 +6,16 @@ using System;
 using System.Collections.Generic;
 using System.Linq;
 using VsChromium.Core.Utility;
+using VsChromium.Core.Win32;
 
 namespace VsChromium.Server.NativeInterop {
   public abstract class CompiledTextSearchBase : ICompiledTextSearch {
-    private static readonly List<TextRange> NoResult = new List<TextRange>();
+    protected static readonly List<TextRange> NoResult = new List<TextRange>();
+    /// <summary>
+    /// The maximum number of matches collected by a single call to <see
+    /// cref="SearchMatches"/>.
+    /// </summary>
+    protected const int MatchBatchSize = 256;
 
     protected abstract int SearchBufferSize { get; }
 
@@ -29,6 +35,51 @@ namespace VsChromium.Server.NativeInterop {
     /// <param name="searchParams"></param>
     protected abstract void Search(ref NativeMethods.SearchParams searchParams);
 
+    /// <summary>
+    /// Perform search steps until the end of the text is reached or <paramref
+    /// name="capacity"/> matches have been stored into <paramref
+    /// name="matches"/>, and return the number of matches stored. Match
+    /// offsets are in bytes from <see
+    /// cref="NativeMethods.SearchParams.TextStart"/>.
+    /// If the return value is <paramref name="capacity"/>, the next call
+    /// resumes the search after the last match.
+    /// The default implementation calls <see cref="Search"/> once per match.
+    /// </summary>
+    protected virtual unsafe int SearchMatches(
+      ref NativeMethods.SearchParams searchParams,
+      NativeMethods.SearchMatch* matches,
+      int capacity) {
+      var count = 0;
+      while (count < capacity) {
+        Search(ref searchParams);
+        if (searchParams.MatchStart == IntPtr.Zero)
+          break;
+
+        matches[count].Offset = Pointers.Offset32(searchParams.TextStart, searchParams.MatchStart);
+        matches[count].Length = searchParams.MatchLength;
+        count++;
+      }
+      return count;
+    }
+
+    /// <summary>
+    /// Count the matches from the current position of <paramref
+    /// name="searchParams"/> up to the end of the text, stopping at <paramref
+    /// name="maxCount"/> matches. No search state is left to cancel.
+    /// The default implementation calls <see cref="Search"/> once per match.
+    /// </summary>
+    protected virtual int Count(ref NativeMethods.SearchParams searchParams, int maxCount) {
+      var count = 0;
+      while (count < maxCount) {
+        Search(ref searchParams);
+        if (searchParams.MatchStart == IntPtr.Zero)
+          return count;
+        count++;
+      }
+      CancelSearch(ref searchParams);
+      return count;
+    }
+
     /// <summary>
     /// If the search is abandonned before all hits have been found, this method
     /// is called to allow the implementation to cleanup intermediate data
@@ -42,18 +93,45 @@ namespace VsChromium.Server.NativeInterop {
     public IList<TextRange> FindAll(TextFragment textFragment, Func<TextRange, TextRange?> postProcess, IOperationProgressTracker progressTracker) {
       if (progressTracker.ShouldEndProcessing)
         return NoResult;
-      return FindWorker(textFragment, postProcess, progressTracker, int.MaxValue);
+      return FindWorker(textFragment, textFragment, postProcess, progressTracker, int.MaxValue);
     }
 
     public TextRange? FindFirst(TextFragment textFragment, IOperationProgressTracker progressTracker) {
-      var result = FindWorker(textFragment, x => x, progressTracker, 1);
+      var result = FindWorker(textFragment, textFragment, x => x, progressTracker, 1);
       if (result.Count == 0)
         return null;
       return result.First();
     }
 
+    public unsafe int Count(TextFragment textFragment, int maxCount) {
+      // Note: From C# spec: If E is zero, then no allocation is made, and
+      // the pointer returned is implementation-defined.
+      byte* searchBuffer = stackalloc byte[this.SearchBufferSize];
+      var searchParams = new NativeMethods.SearchParams {
+        TextStart = textFragment.StartPtr,
+        TextLength = textFragment.Length,
+        SearchBuffer = new IntPtr(searchBuffer),
+      };
+      return Count(ref searchParams, maxCount);
+    }
+
+    /// <summary>
+    /// Same as <see cref="FindAll"/>, except the implementation may look at
+    /// the text of <paramref name="contextFragment"/>, which contains
+    /// <paramref name="textFragment"/>.
+    /// </summary>
+    protected IList<TextRange> FindAllInContext(
+      TextFragment textFragment,
+      TextFragment contextFragment,
+      IOperationProgressTracker progressTracker) {
+      if (progressTracker.ShouldEndProcessing)
+        return NoResult;
+      return FindWorker(textFragment, contextFragment, x => x, progressTracker, int.MaxValue);
+    }
+
     private unsafe List<TextRange> FindWorker(
       TextFragment textFragment,
+      TextFragment contextFragment,
       Func<TextRange, TextRange?> postProcess, 
       IOperationProgressTracker progressTracker,
       int maxResultSize) {
@@ -66,36 +144,48 @@ namespace VsChromium.Server.NativeInterop {
         TextStart = textFragment.StartPtr,
         TextLength = textFragment.Length,
         SearchBuffer = new IntPtr(searchBuffer),
+        ContextStart = contextFragment.StartPtr,
+        ContextLength = contextFragment.Length,
+        Cancelled = progressTracker.CancelledFlag,
       };
 
+      // Collect matches in batches to limit the number of native calls.
+      var capacity = Math.Min(MatchBatchSize, maxResultSize);
+      var matches = stackalloc NativeMethods.SearchMatch[capacity];
       while (true) {
-        // Perform next search
-        Search(ref searchParams);
-        if (searchParams.MatchStart == IntPtr.Zero)
-          break;
+        // Perform next searches
+        var matchCount = SearchMatches(ref searchParams, matches, capacity);
+
+        for (var i = 0; i < matchCount; i++) {
+          // Convert match from *byte* offset to a *text* range
+          var matchFragment = textFragment.Sub(searchParams.TextStart + matches[i].Offset, matches[i].Length);
+          var matchRange = new TextRange(matchFragment.Position, matchFragment.Length);
+
+          // Post process match, maybe skipping it
+          var postMatchRange = postProcess(matchRange);
+          if (postMatchRange == null)
+            continue;
+          matchRange = postMatchRange.Value;
+
+          // Add to result collection
+          if (result == null)
+            result = new List<TextRange>();
+          result.Add(matchRange);
+
+          // Check it is time to end processing early.
+          maxResultSize--;
+          progressTracker.AddResults(1);
+          if (maxResultSize <= 0 || progressTracker.ShouldEndProcessing) {
+            // The search may have reached the end of the text already.
+            if (searchParams.MatchStart != IntPtr.Zero)
+              CancelSearch(ref searchParams);
+            return result;
+          }
+        }
 
-        // Convert match from *byte* pointers to a *text* range
-        var matchFragment = textFragment.Sub(searchParams.MatchStart, searchParams.MatchLength);
-        var matchRange = new TextRange(matchFragment.Position, matchFragment.Length);
-
-        // Post process match, maybe skipping it
-        var postMatchRange = postProcess(matchRange);
-        if (postMatchRange == null)
-          continue;
-        matchRange = postMatchRange.Value;
-
-        // Add to result collection
-        if (result == null)
-          result = new List<TextRange>();
-        result.Add(matchRange);
-
-        // Check it is time to end processing early.
-        maxResultSize--;
-        progressTracker.AddResults(1);
-        if (maxResultSize <= 0 || progressTracker.ShouldEndProcessing) {
-          CancelSearch(ref searchParams);
+        // The end of the text has been reached
+        if (matchCount < capacity)
           break;
-        }
       }
 
       return result ?? NoResult;
@@ -27,5 +27,12 @@ namespace VsChromium.Server.NativeInterop {
     TextRange? FindFirst(
       TextFragment textFragment,
       IOperationProgressTracker progressTracker);
+
+    /// <summary>
+    /// Count the occurrences of the stored search pattern in the given text
+    /// fragment, stopping at <paramref name="maxCount"/> occurrences. Use a
+    /// <paramref name="maxCount"/> of 1 to check if there is any occurrence.
+    /// </summary>
+    int Count(TextFragment textFragment, int maxCount);
   }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 using System;
 using System.Runtime.InteropServices;
 using System.Security;
+using System.Text;
 
 namespace VsChromium.Server.NativeInterop {
   public static class NativeMethods {
@@ -15,6 +16,25 @@ namespace VsChromium.Server.NativeInterop {
       kBoyerMoore = 4,
       kRegex = 5,
       kRe2 = 6,
+      kSimdLiteral = 7,
+      kMultiLiteral = 8,
+      kWildcard = 9,
+      kBndmLong = 10,
+      kTwoWay = 11,
+      kUtf8CaseFolding = 12,
+      kUtf16Bndm = 13,
+      kUtf16SimdLiteral = 14,
+      kApproximate = 15,
+    }
+
+    /// <summary>
+    /// The engine a <see cref="SearchAlgorithmKind.kRegex"/> search
+    /// algorithm runs: RE2 unless the pattern needs std::regex, e.g. for
+    /// backreferences or lookahead assertions.
+    /// </summary>
+    public enum RegexEngine {
+      kStdRegex = 0,
+      kRe2 = 1,
     }
 
     [Flags]
@@ -22,6 +42,23 @@ namespace VsChromium.Server.NativeInterop {
       kNone = 0x0000,
       kMatchCase = 0x0001,
       kMatchWholeWord = 0x0002,
+      kPerByteCaseFolding = 0x0004,
+      kNoRegexTranslation = 0x0008,
+      kMaxErrorsMask = 0x00F0,
+    }
+
+    /// <summary>
+    /// Position of the number of errors allowed by approximate searches in
+    /// <see cref="SearchOptions"/>.
+    /// </summary>
+    public const int SearchOptionsMaxErrorsShift = 4;
+
+    [Flags]
+    public enum CpuFeatures {
+      kNone = 0x0000,
+      kSse2 = 0x0001,
+      kSse42 = 0x0002,
+      kAvx2 = 0x0004,
     }
 
     public enum TextKind {
@@ -32,13 +69,91 @@ namespace VsChromium.Server.NativeInterop {
       TextKind_ProbablyBinary,
     }
 
+    /// <summary>
+    /// The 64-bit version of <see cref="SearchParams"/>, used by the "64"
+    /// exports to search texts of 2GB or more.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchParams64 {
+      public IntPtr TextStart;
+      public long TextLength;
+      public IntPtr MatchStart;
+      public long MatchLength;
+      public int MatchPatternIndex;
+      public IntPtr SearchBuffer;
+      public IntPtr ContextStart;
+      public long ContextLength;
+      /// <summary>
+      /// Optional pointer to a flag set to a non-zero value to stop the
+      /// search, see <see cref="CompiledTextSearchBase"/>.
+      /// </summary>
+      public IntPtr Cancelled;
+    }
+
+    /// <summary>
+    /// Number of regular expressions found in the cache of compiled
+    /// patterns (<see cref="Hits"/>) or compiled (<see cref="Misses"/>)
+    /// when creating <see cref="SearchAlgorithmKind.kRegex"/> and <see
+    /// cref="SearchAlgorithmKind.kRe2"/> search algorithms.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct CompiledPatternCacheStatistics {
+      public long Hits;
+      public long Misses;
+      public long Evictions;
+      public int EntryCount;
+      public int Capacity;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchMatch64 {
+      public long Offset;
+      public long Length;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchFragment64 {
+      public IntPtr TextStart;
+      public long TextLength;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchFragmentMatch64 {
+      public int FragmentIndex;
+      public long Offset;
+      public long Length;
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     public struct SearchParams {
       public IntPtr TextStart;
       public int TextLength;
       public IntPtr MatchStart;
       public int MatchLength;
+      public int MatchPatternIndex;
       public IntPtr SearchBuffer;
+      public IntPtr ContextStart;
+      public int ContextLength;
+      public IntPtr Cancelled;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchMatch {
+      public int Offset;
+      public int Length;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchFragment {
+      public IntPtr TextStart;
+      public int TextLength;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchFragmentMatch {
+      public int FragmentIndex;
+      public int Offset;
+      public int Length;
     }
 
     [StructLayout(LayoutKind.Sequential)]
@@ -47,6 +162,26 @@ namespace VsChromium.Server.NativeInterop {
       public fixed byte ErrorMessage [128];
     }
 
+    /// <summary>
+    /// The algorithm selected by <see
+    /// cref="AsciiSearchAlgorithm_CreateBest"/>, and its throughput on the
+    /// sample of the files loaded so far (0 if no file has been loaded).
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SearchAlgorithmChoice {
+      public SearchAlgorithmKind Kind;
+      public int SampleLength;
+      public double BytesPerSecond;
+    }
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern CpuFeatures Native_GetCpuFeatures();
+
     [SuppressUnmanagedCodeSecurity]
     [DllImport(
       "VsChromium.Native.dll",
@@ -60,6 +195,32 @@ namespace VsChromium.Server.NativeInterop {
       SearchOptions options,
       [Out]out SearchCreateResult result);
 
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern SafeSearchHandle Utf16SearchAlgorithm_Create(
+      SearchAlgorithmKind kind,
+      IntPtr pattern,
+      int patternLen,
+      SearchOptions options,
+      [Out]out SearchCreateResult result);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern SafeSearchHandle AsciiSearchAlgorithm_CreateBest(
+      IntPtr pattern,
+      int patternLen,
+      SearchOptions options,
+      [Out]out SearchCreateResult result,
+      [Out]out SearchAlgorithmChoice choice);
+
     [SuppressUnmanagedCodeSecurity]
     [DllImport(
       "VsChromium.Native.dll",
@@ -79,6 +240,47 @@ namespace VsChromium.Server.NativeInterop {
       SafeSearchHandle handle,
       ref SearchParams searchParams);
 
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_FindAll(
+      SafeSearchHandle handle,
+      ref SearchParams searchParams,
+      IntPtr matches,
+      int capacity,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_FindAllFragments(
+      SafeSearchHandle handle,
+      IntPtr fragments,
+      int fragmentCount,
+      ref int fragmentIndex,
+      ref SearchParams searchParams,
+      IntPtr matches,
+      int capacity,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_Count(
+      SafeSearchHandle handle,
+      ref SearchParams searchParams,
+      int maxCount,
+      out int matchCount);
+
     [SuppressUnmanagedCodeSecurity]
     [DllImport(
       "VsChromium.Native.dll",
@@ -89,6 +291,67 @@ namespace VsChromium.Server.NativeInterop {
       SafeSearchHandle handle,
       ref SearchParams searchParams);
 
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_Search64(
+      SafeSearchHandle handle,
+      ref SearchParams64 searchParams);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_FindAll64(
+      SafeSearchHandle handle,
+      ref SearchParams64 searchParams,
+      IntPtr matches,
+      int capacity,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_FindAllFragments64(
+      SafeSearchHandle handle,
+      IntPtr fragments,
+      int fragmentCount,
+      ref int fragmentIndex,
+      ref SearchParams64 searchParams,
+      IntPtr matches,
+      int capacity,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_Count64(
+      SafeSearchHandle handle,
+      ref SearchParams64 searchParams,
+      int maxCount,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void AsciiSearchAlgorithm_CancelSearch64(
+      SafeSearchHandle handle,
+      ref SearchParams64 searchParams);
+
     [SuppressUnmanagedCodeSecurity]
     [DllImport(
       "VsChromium.Native.dll",
@@ -97,6 +360,97 @@ namespace VsChromium.Server.NativeInterop {
       SetLastError = false)]
     public static extern void AsciiSearchAlgorithm_Delete(IntPtr handle);
 
+    /// <summary>
+    /// Copies the literal strings searched before running RE2, separated by
+    /// '\n', to <paramref name="buffer"/> if it has room for them, and
+    /// returns their length. <paramref name="handle"/> must be a <see
+    /// cref="SearchAlgorithmKind.kRe2"/> search algorithm.
+    /// </summary>
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern int RE2Search_GetPrefilterAtoms(
+      SafeSearchHandle handle,
+      StringBuilder buffer,
+      int bufferLength);
+
+    /// <summary>
+    /// Returns the engine <paramref name="handle"/>, a <see
+    /// cref="SearchAlgorithmKind.kRegex"/> search algorithm, runs.
+    /// </summary>
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern RegexEngine RegexSearch_GetEngine(SafeSearchHandle handle);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void CompiledPatternCache_GetStatistics(
+      out CompiledPatternCacheStatistics statistics);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern SafeStreamingSearchHandle StreamingSearch_Create(
+      SafeSearchHandle search,
+      SearchOptions options,
+      long maxMatchLength);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void StreamingSearch_FeedChunk(
+      SafeStreamingSearchHandle handle,
+      IntPtr chunk,
+      long chunkLength,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void StreamingSearch_Finish(
+      SafeStreamingSearchHandle handle,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void StreamingSearch_FetchMatches(
+      SafeStreamingSearchHandle handle,
+      IntPtr matches,
+      int capacity,
+      out int matchCount);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    public static extern void StreamingSearch_Delete(IntPtr handle);
+
     [SuppressUnmanagedCodeSecurity]
     [DllImport(
       "VsChromium.Native.dll",
@@ -154,11 +508,28 @@ namespace VsChromium.Server.NativeInterop {
       CallingConvention = CallingConvention.StdCall,
       CharSet = CharSet.Ansi,
       SetLastError = false)]
-    public static extern IntPtr Utf16_Search(
+    [return: MarshalAs(UnmanagedType.I1)]
+    public static extern bool Ascii_GetLineExtentFromPosition64(
       IntPtr text,
-      long textLength,
-      IntPtr pattern,
-      long patternLength,
-      SearchOptions options);
+      long textLen,
+      long position,
+      int maxOffset,
+      out long lineStartPosition,
+      out long lineLength);
+
+    [SuppressUnmanagedCodeSecurity]
+    [DllImport(
+      "VsChromium.Native.dll",
+      CallingConvention = CallingConvention.StdCall,
+      CharSet = CharSet.Ansi,
+      SetLastError = false)]
+    [return: MarshalAs(UnmanagedType.I1)]
+    public static extern bool Utf16_GetLineExtentFromPosition64(
+      IntPtr text,
+      long textLen,
+      long position,
+      int maxOffset,
+      out long lineStartPosition,
+      out long lineLength);
   }
 }
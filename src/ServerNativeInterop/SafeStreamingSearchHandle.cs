@@ -0,0 +1,18 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using Microsoft.Win32.SafeHandles;
+
+namespace VsChromium.Server.NativeInterop {
+  public sealed class SafeStreamingSearchHandle : SafeHandleZeroOrMinusOneIsInvalid {
+    internal SafeStreamingSearchHandle()
+      : base(true) {
+    }
+
+    protected override bool ReleaseHandle() {
+      NativeMethods.StreamingSearch_Delete(handle);
+      return true;
+    }
+  }
+}
@@ -0,0 +1,47 @@
+﻿// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+using System.Runtime.InteropServices;
+using VsChromium.Core.Win32.Memory;
+
+namespace VsChromium.Server.NativeInterop {
+  /// <summary>
+  /// Literal search of UTF-16 text using the native algorithms of <see
+  /// cref="AsciiCompiledTextSearchNative"/>, with patterns and text lengths
+  /// in characters. As for ASCII text, case insensitive searches only fold
+  /// 'A' to 'Z'.
+  /// </summary>
+  public class Utf16CompiledTextSearchNative : AsciiCompiledTextSearchNative {
+    public Utf16CompiledTextSearchNative(
+        NativeMethods.SearchAlgorithmKind kind,
+        string pattern,
+        NativeMethods.SearchOptions searchOptions)
+      : this(kind, new SafeHGlobalHandle(Marshal.StringToHGlobalUni(pattern)), pattern.Length, searchOptions) {
+    }
+
+    private Utf16CompiledTextSearchNative(
+        NativeMethods.SearchAlgorithmKind kind,
+        SafeHGlobalHandle patternHandle,
+        int patternLength,
+        NativeMethods.SearchOptions searchOptions)
+      : base(patternHandle, CreateUtf16SearchHandle(kind, patternHandle, patternLength, searchOptions)) {
+    }
+
+    private static SafeSearchHandle CreateUtf16SearchHandle(
+        NativeMethods.SearchAlgorithmKind kind,
+        SafeHGlobalHandle patternHandle,
+        int patternLength,
+        NativeMethods.SearchOptions searchOptions) {
+      NativeMethods.SearchCreateResult createResult;
+      var result = NativeMethods.Utf16SearchAlgorithm_Create(
+          kind,
+          patternHandle.Pointer,
+          patternLength,
+          searchOptions,
+          out createResult);
+      CheckCreateResult(ref createResult);
+      return result;
+    }
+  }
+}
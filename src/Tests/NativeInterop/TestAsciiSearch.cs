@@ -2,8 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+using System;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading.Tasks;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 using VsChromium.Core.Utility;
 using VsChromium.Core.Win32.Memory;
@@ -18,6 +23,14 @@ namespace VsChromium.Tests.NativeInterop {
       block.Close();
     }
 
+    [TestMethod]
+    public void GetCpuFeaturesWorks() {
+      // SSE2 is part of the x64 instruction set.
+      var features = NativeMethods.Native_GetCpuFeatures();
+      Trace.WriteLine(string.Format("CPU features: {0}", features));
+      Assert.IsTrue((features & NativeMethods.CpuFeatures.kSse2) != 0);
+    }
+
     [TestMethod]
     public void AsciiSearchForVariousPatternsWorks() {
       const int oneKB = 1024;
@@ -110,9 +123,940 @@ namespace VsChromium.Tests.NativeInterop {
                                         matchCount, iterationCount, sw.Elapsed.TotalSeconds,
                                         ComputeThroughput(sw, blockByteLength, iterationCount)));
         }
+        using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, searchOptions)) {
+          var sw = Stopwatch.StartNew();
+          var matchCount = PerformSearch(textBlock, search, iterationCount);
+          sw.Stop();
+          Assert.AreEqual(patternOccurrenceCount, matchCount);
+          Trace.WriteLine(string.Format("  SIMD literal: Found {0:n0} occurrence(s) {1} times in {2} s ({3:n0} KB/s.)",
+                                        matchCount, iterationCount, sw.Elapsed.TotalSeconds,
+                                        ComputeThroughput(sw, blockByteLength, iterationCount)));
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchCaseFoldingWorks() {
+      const int tenMB = 10 * 1024 * 1024;
+      const int iterationCount = 2;
+      const int matchCount = 100;
+      // Mixed case pattern, so that case folding matters.
+      const string pattern = "FooBarBlah";
+
+      using (var textBlock = HeapAllocStatic.Alloc(tenMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, pattern.ToLowerInvariant(), matchCount);
+
+        Trace.WriteLine(
+          string.Format(
+            "Searching {0} time(s) for pattern \"{1}\" (case insensitive) with {2} occurrence(s) in a memory block of {3:n0} bytes.",
+            iterationCount, pattern, matchCount, tenMB));
+        foreach (var options in new[] { NativeMethods.SearchOptions.kNone, NativeMethods.SearchOptions.kPerByteCaseFolding }) {
+          using (var search = new AsciiCompiledTextSearchBndm64(pattern, options)) {
+            MeasureSearch("BNDM-64 " + options, textBlock, search, matchCount, iterationCount);
+          }
+          using (var search = new AsciiCompiledTextSearchBoyerMoore(pattern, options)) {
+            MeasureSearch("Boyer-Moore " + options, textBlock, search, matchCount, iterationCount);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchLongPatternWorks() {
+      const int tenMB = 10 * 1024 * 1024;
+      const int iterationCount = 2;
+      const int matchCount = 100;
+      // Longer than the 64 characters supported by BNDM-64.
+      const string pattern =
+        "Unhandled exception at 0x00007FF6 in chrome.exe: 0xC0000005: Access violation reading location 0x18.";
+
+      using (var textBlock = HeapAllocStatic.Alloc(tenMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, pattern, matchCount);
+
+        Trace.WriteLine(
+          string.Format(
+            "Searching {0} time(s) for pattern of {1} characters with {2} occurrence(s) in a memory block of {3:n0} bytes.",
+            iterationCount, pattern.Length, matchCount, tenMB));
+        foreach (var options in new[] { NativeMethods.SearchOptions.kMatchCase, NativeMethods.SearchOptions.kNone }) {
+          using (var search = new AsciiCompiledTextSearchBndmLong(pattern, options)) {
+            MeasureSearch("BNDM-long " + options, textBlock, search, matchCount, iterationCount);
+          }
+          using (var search = new AsciiCompiledTextSearchBoyerMoore(pattern, options)) {
+            MeasureSearch("Boyer-Moore " + options, textBlock, search, matchCount, iterationCount);
+          }
+          using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, options)) {
+            MeasureSearch("SIMD literal " + options, textBlock, search, matchCount, iterationCount);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchMultiLiteralWorks() {
+      const int tenMB = 10 * 1024 * 1024;
+      const int iterationCount = 2;
+      const int matchCount = 100;
+      var patterns = new[] { "NotPresent", "FooBarBlah", "AlsoNotPresent" };
+
+      using (var textBlock = HeapAllocStatic.Alloc(tenMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, patterns[1], matchCount);
+
+        Trace.WriteLine(
+          string.Format(
+            "Searching {0} time(s) for patterns \"{1}\" with {2} occurrence(s) in a memory block of {3:n0} bytes.",
+            iterationCount, string.Join("|", patterns), matchCount, tenMB));
+        foreach (var options in new[] { NativeMethods.SearchOptions.kMatchCase, NativeMethods.SearchOptions.kNone }) {
+          using (var search = new AsciiCompiledTextSearchMultiLiteral(patterns, options)) {
+            MeasureSearch("Multi literal " + options, textBlock, search, matchCount, iterationCount);
+          }
+          using (var search = new AsciiCompiledTextSearchRe2(string.Join("|", patterns), options)) {
+            MeasureSearch("RE2 " + options, textBlock, search, matchCount, iterationCount);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchFindAllResumesAfterFullBatch() {
+      const int oneMB = 1024 * 1024;
+      // More matches than fit in a single batch of native results.
+      const int matchCount = 1000;
+      const string pattern = "foo";
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, pattern, matchCount);
+
+        foreach (var options in new[] { NativeMethods.SearchOptions.kMatchCase, NativeMethods.SearchOptions.kMatchWholeWord }) {
+          using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, options)) {
+            MeasureSearch("SIMD literal " + options, textBlock, search, matchCount, 1);
+
+            var fragment = new TextFragment(textBlock.Pointer, 0, textBlock.ByteLength, sizeof(byte));
+            Assert.AreEqual(matchCount, search.Count(fragment, int.MaxValue));
+            Assert.AreEqual(10, search.Count(fragment, 10));
+          }
+
+          // RE2 also finds its matches in batches of native results.
+          using (var search = new AsciiCompiledTextSearchRe2(pattern, options)) {
+            MeasureSearch("RE2 " + options, textBlock, search, matchCount, 1);
+
+            var fragment = new TextFragment(textBlock.Pointer, 0, textBlock.ByteLength, sizeof(byte));
+            Assert.AreEqual(matchCount, search.Count(fragment, int.MaxValue));
+            Assert.AreEqual(10, search.Count(fragment, 10));
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchRe2PrefilterWorks() {
+      const int oneMB = 1024 * 1024;
+      const int matchCount = 1000;
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, "fooBar(", matchCount);
+
+        foreach (var options in new[] { NativeMethods.SearchOptions.kMatchCase, NativeMethods.SearchOptions.kNone }) {
+          // RE2 cannot skip quickly to the start of a match, but the text
+          // can be searched for "bar(" first.
+          using (var search = new AsciiCompiledTextSearchRe2("[a-z]+Bar\\(", options)) {
+            CollectionAssert.AreEqual(new[] { "bar(" }, search.PrefilterAtoms.ToList());
+            MeasureSearch("RE2 with prefilter " + options, textBlock, search, matchCount, 1);
+          }
+
+          // Matches may span several lines: RE2 runs on the whole text.
+          using (var search = new AsciiCompiledTextSearchRe2("[a-z\\n]+Bar\\(", options)) {
+            Assert.AreEqual(0, search.PrefilterAtoms.Count);
+            MeasureSearch("RE2 without prefilter " + options, textBlock, search, matchCount, 1);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchRegexRunsRe2WhenPossible() {
+      const int oneMB = 1024 * 1024;
+      const int matchCount = 1000;
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, "fooBar(", matchCount);
+
+        foreach (var options in new[] { NativeMethods.SearchOptions.kMatchCase, NativeMethods.SearchOptions.kNone }) {
+          using (var search = new AsciiCompiledTextSearchRegex("[a-z]+Bar\\(", options)) {
+            Assert.AreEqual(NativeMethods.RegexEngine.kRe2, search.Engine);
+            MeasureSearch("Regex with RE2 " + options, textBlock, search, matchCount, 1);
+          }
+
+          // RE2 has no backreferences.
+          using (var search = new AsciiCompiledTextSearchRegex("([a-z])\\1Bar\\(", options)) {
+            Assert.AreEqual(NativeMethods.RegexEngine.kStdRegex, search.Engine);
+            MeasureSearch("Regex with std::regex " + options, textBlock, search, matchCount, 1);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchRegexMatchesSameTextWithRe2() {
+      var re2 = NativeMethods.RegexEngine.kRe2;
+      var stdRegex = NativeMethods.RegexEngine.kStdRegex;
+      var matchCase = NativeMethods.SearchOptions.kMatchCase;
+      var tests = new[] {
+        // ECMAScript '.' matches neither '\r' nor '\n'.
+        new { Pattern = "a.b", Text = "a\rb a\nb axb", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(8, 3) } },
+        // ECMAScript "\s" matches '\v'.
+        new { Pattern = "a\\sb", Text = "a\vb a b", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(0, 3), new TextRange(4, 3) } },
+        // Negated classes match '\n'.
+        new { Pattern = "[^a]+", Text = "aa\nbb", Options = NativeMethods.SearchOptions.kNone, Engine = re2,
+              Matches = new[] { new TextRange(2, 3) } },
+        new { Pattern = "\\x80+", Text = "a\u0080\u0080", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(1, 2) } },
+        // RE2 folds non ASCII characters beyond ASCII.
+        new { Pattern = "\\x80+", Text = "a\u0080\u0080", Options = NativeMethods.SearchOptions.kNone, Engine = stdRegex,
+              Matches = new[] { new TextRange(1, 2) } },
+        new { Pattern = "a{2,}", Text = "a aaaaa", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(2, 5) } },
+        new { Pattern = "a+?", Text = "aaa", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(0, 1), new TextRange(1, 1), new TextRange(2, 1) } },
+        new { Pattern = "a.*?b", Text = "axbxb", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(0, 3) } },
+        new { Pattern = "\\bfoo\\b", Text = "foo foobar", Options = matchCase, Engine = re2,
+              Matches = new[] { new TextRange(0, 3) } },
+        // Patterns matching the empty text are left to std::regex, which
+        // reports empty matches with a length of 0, and looks for a non
+        // empty match at the same position after them.
+        new { Pattern = "a*", Text = "baab", Options = matchCase, Engine = stdRegex,
+              Matches = new[] { new TextRange(0, 0), new TextRange(1, 2), new TextRange(3, 0), new TextRange(4, 0) } },
+        new { Pattern = "|b+", Text = "abb", Options = matchCase, Engine = stdRegex,
+              Matches = new[] { new TextRange(0, 0), new TextRange(1, 0), new TextRange(1, 2), new TextRange(3, 0) } },
+        new { Pattern = "A??\\.?", Text = "a.", Options = NativeMethods.SearchOptions.kNone, Engine = stdRegex,
+              Matches = new[] { new TextRange(0, 0), new TextRange(0, 2), new TextRange(2, 0) } },
+      };
+
+      foreach (var test in tests) {
+        var bytes = test.Text.Select(c => (byte)c).ToArray();
+        using (var textBlock = HeapAllocStatic.Alloc(bytes.Length)) {
+          Marshal.Copy(bytes, 0, textBlock.Pointer, bytes.Length);
+          var fragment = new TextFragment(textBlock.Pointer, 0, bytes.Length, sizeof(byte));
+
+          using (var search = new AsciiCompiledTextSearchRegex(test.Pattern, test.Options | NativeMethods.SearchOptions.kNoRegexTranslation)) {
+            Assert.AreEqual(stdRegex, search.Engine, test.Pattern);
+            var matches = search.FindAll(fragment, x => x, OperationProgressTracker.None);
+            CollectionAssert.AreEqual(test.Matches, matches.ToList(), test.Pattern);
+          }
+
+          using (var search = new AsciiCompiledTextSearchRegex(test.Pattern, test.Options)) {
+            Assert.AreEqual(test.Engine, search.Engine, test.Pattern);
+            var matches = search.FindAll(fragment, x => x, OperationProgressTracker.None);
+            CollectionAssert.AreEqual(test.Matches, matches.ToList(), test.Pattern);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchReusesCompiledRegex() {
+      const int oneMB = 1024 * 1024;
+      const int matchCount = 1000;
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, "fooBar(", matchCount);
+
+        // The second search of each pattern starts from the compiled pattern
+        // of the first one, and must find the same matches.
+        var pattern = "[a-z]+Bar\\(";
+        using (var search = new AsciiCompiledTextSearchRe2(pattern, NativeMethods.SearchOptions.kNone)) {
+          MeasureSearch("RE2 compiled", textBlock, search, matchCount, 1);
+        }
+        using (var search = new AsciiCompiledTextSearchRegex(pattern, NativeMethods.SearchOptions.kNone)) {
+          MeasureSearch("Regex compiled", textBlock, search, matchCount, 1);
+        }
+
+        NativeMethods.CompiledPatternCacheStatistics before;
+        NativeMethods.CompiledPatternCache_GetStatistics(out before);
+        using (var search = new AsciiCompiledTextSearchRe2(pattern, NativeMethods.SearchOptions.kNone)) {
+          MeasureSearch("RE2 cached", textBlock, search, matchCount, 1);
+        }
+        using (var search = new AsciiCompiledTextSearchRegex(pattern, NativeMethods.SearchOptions.kNone)) {
+          MeasureSearch("Regex cached", textBlock, search, matchCount, 1);
+        }
+        NativeMethods.CompiledPatternCacheStatistics after;
+        NativeMethods.CompiledPatternCache_GetStatistics(out after);
+        Assert.AreEqual(before.Hits + 2, after.Hits);
+        Assert.AreEqual(before.Misses, after.Misses);
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearch64BitExportsWork() {
+      const int oneMB = 1024 * 1024;
+      const int matchCount = 1000;
+      const string pattern = "foo";
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB))
+      using (var patternHandle = new SafeHGlobalHandle(Marshal.StringToHGlobalAnsi(pattern))) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, pattern, matchCount);
+
+        NativeMethods.SearchCreateResult createResult;
+        using (var handle = NativeMethods.AsciiSearchAlgorithm_Create(
+          NativeMethods.SearchAlgorithmKind.kSimdLiteral,
+          patternHandle.Pointer,
+          pattern.Length,
+          NativeMethods.SearchOptions.kMatchCase,
+          out createResult)) {
+          Assert.IsTrue(createResult.HResult >= 0);
+          var searchBuffer = stackalloc byte[NativeMethods.AsciiSearchAlgorithm_GetSearchBufferSize(handle) + 1];
+
+          // The 64-bit exports find the same matches as the 32-bit ones.
+          var matches32 = stackalloc NativeMethods.SearchMatch[matchCount];
+          var searchParams32 = new NativeMethods.SearchParams {
+            TextStart = textBlock.Pointer,
+            TextLength = textBlock.ByteLength,
+            SearchBuffer = new IntPtr(searchBuffer),
+          };
+          int matchCount32;
+          NativeMethods.AsciiSearchAlgorithm_FindAll(
+            handle, ref searchParams32, new IntPtr(matches32), matchCount, out matchCount32);
+
+          var matches64 = stackalloc NativeMethods.SearchMatch64[matchCount];
+          var searchParams64 = new NativeMethods.SearchParams64 {
+            TextStart = textBlock.Pointer,
+            TextLength = textBlock.ByteLength,
+            SearchBuffer = new IntPtr(searchBuffer),
+          };
+          int matchCount64;
+          NativeMethods.AsciiSearchAlgorithm_FindAll64(
+            handle, ref searchParams64, new IntPtr(matches64), matchCount, out matchCount64);
+
+          Assert.AreEqual(matchCount, matchCount32);
+          Assert.AreEqual(matchCount, matchCount64);
+          for (var i = 0; i < matchCount; i++) {
+            Assert.AreEqual((long)matches32[i].Offset, matches64[i].Offset);
+            Assert.AreEqual((long)matches32[i].Length, matches64[i].Length);
+          }
+
+          searchParams64 = new NativeMethods.SearchParams64 {
+            TextStart = textBlock.Pointer,
+            TextLength = textBlock.ByteLength,
+            SearchBuffer = new IntPtr(searchBuffer),
+          };
+          NativeMethods.AsciiSearchAlgorithm_Search64(handle, ref searchParams64);
+          Assert.AreEqual(textBlock.Pointer.ToInt64() + matches64[0].Offset, searchParams64.MatchStart.ToInt64());
+          Assert.AreEqual((long)pattern.Length, searchParams64.MatchLength);
+
+          int count64;
+          NativeMethods.AsciiSearchAlgorithm_Count64(handle, ref searchParams64, int.MaxValue, out count64);
+          Assert.AreEqual(matchCount - 1, count64);
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchRe2ScalesWithThreadCount() {
+      const int tenMB = 10 * 1024 * 1024;
+      // The size of the pieces of files searched by the search engine.
+      const int pieceLength = 100 * 1024;
+      const int matchCount = 1000;
+      const string pattern = "foo[a-z]+bar";
+
+      using (var textBlock = HeapAllocStatic.Alloc(tenMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, "fooxbar", matchCount);
+        var pieces = Enumerable.Range(0, tenMB / pieceLength)
+          .Select(i => new TextFragment(textBlock.Pointer, i * pieceLength, pieceLength, sizeof(byte)))
+          .ToList();
+
+        using (var search = new AsciiCompiledTextSearchRe2(pattern, NativeMethods.SearchOptions.kMatchCase)) {
+          // Matches spanning two pieces are not found.
+          var expectedMatchCount = pieces.Sum(x => search.FindAll(x, y => y, OperationProgressTracker.None).Count);
+          Assert.IsTrue(expectedMatchCount > 0);
+          var singleThreadThroughput = 0.0;
+          for (var threadCount = 1; threadCount <= Environment.ProcessorCount; threadCount *= 2) {
+            const int iterationCount = 4;
+            var sw = Stopwatch.StartNew();
+            var matchCounts = new int[threadCount];
+            Parallel.For(0, threadCount, new ParallelOptions { MaxDegreeOfParallelism = threadCount }, t => {
+              for (var i = 0; i < iterationCount; i++) {
+                matchCounts[t] = pieces.Sum(x => search.FindAll(x, y => y, OperationProgressTracker.None).Count);
+              }
+            });
+            sw.Stop();
+            Assert.IsTrue(matchCounts.All(x => x == expectedMatchCount));
+
+            var throughput = ComputeThroughput(sw, (long)tenMB * threadCount, iterationCount);
+            if (threadCount == 1)
+              singleThreadThroughput = throughput;
+            Trace.WriteLine(string.Format("  RE2 with {0} thread(s): {1:n0} KB/s ({2:n1}x)",
+                                          threadCount, throughput, throughput / singleThreadThroughput));
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchRegexStopsWhenCancelled() {
+      const int oneMB = 1024 * 1024;
+      const string pattern = "fo+bar";
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB))
+      using (var patternHandle = new SafeHGlobalHandle(Marshal.StringToHGlobalAnsi(pattern))) {
+        FillWithNonNulCharacters(textBlock);
+        // The only match is at the end of the text, so that the cancellation
+        // flag is checked before it is found.
+        var text = (byte*)textBlock.Pointer.ToPointer();
+        var matchText = Encoding.ASCII.GetBytes("foobar");
+        Marshal.Copy(matchText, 0, new IntPtr(text + textBlock.ByteLength - matchText.Length), matchText.Length);
+
+        foreach (var kind in new[] { NativeMethods.SearchAlgorithmKind.kRegex, NativeMethods.SearchAlgorithmKind.kRe2 }) {
+          NativeMethods.SearchCreateResult createResult;
+          using (var handle = NativeMethods.AsciiSearchAlgorithm_Create(
+            kind,
+            patternHandle.Pointer,
+            pattern.Length,
+            NativeMethods.SearchOptions.kMatchCase,
+            out createResult)) {
+            Assert.IsTrue(createResult.HResult >= 0);
+            var searchBuffer = stackalloc byte[NativeMethods.AsciiSearchAlgorithm_GetSearchBufferSize(handle) + 1];
+
+            foreach (var cancelled in new[] { 0, 1 }) {
+              var flag = cancelled;
+              var searchParams = new NativeMethods.SearchParams {
+                TextStart = textBlock.Pointer,
+                TextLength = textBlock.ByteLength,
+                SearchBuffer = new IntPtr(searchBuffer),
+                Cancelled = new IntPtr(&flag),
+              };
+              NativeMethods.AsciiSearchAlgorithm_Search(handle, ref searchParams);
+              Assert.AreEqual(cancelled == 0, searchParams.MatchStart != IntPtr.Zero, kind.ToString());
+              if (searchParams.MatchStart != IntPtr.Zero)
+                NativeMethods.AsciiSearchAlgorithm_CancelSearch(handle, ref searchParams);
+            }
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiStreamingSearchFindsMatchesAcrossChunks() {
+      const int oneMB = 1024 * 1024;
+      const int matchCount = 1000;
+      const string pattern = "foobar";
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, pattern, matchCount);
+
+        foreach (var options in new[] { NativeMethods.SearchOptions.kMatchCase, NativeMethods.SearchOptions.kMatchWholeWord }) {
+          using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, options))
+          using (var chunkSearch = new AsciiCompiledTextSearchSimdLiteral(pattern, options & ~NativeMethods.SearchOptions.kMatchWholeWord)) {
+            var expected = search.FindAll(
+              new TextFragment(textBlock.Pointer, 0, textBlock.ByteLength, sizeof(byte)),
+              x => x,
+              OperationProgressTracker.None).ToList();
+            Assert.AreEqual(matchCount, expected.Count);
+
+            // Chunk sizes not multiple of the distance between matches, so
+            // that some matches span chunk boundaries.
+            foreach (var chunkSize in new[] { 3, 7, 4095, 65536 }) {
+              using (var streamingSearch = new AsciiStreamingTextSearch(chunkSearch, options, pattern.Length)) {
+                var actual = new List<TextRange>();
+                var text = (byte*)textBlock.Pointer.ToPointer();
+                for (var offset = 0; offset < textBlock.ByteLength; offset += chunkSize) {
+                  var length = Math.Min(chunkSize, textBlock.ByteLength - offset);
+                  actual.AddRange(streamingSearch.FeedChunk(new IntPtr(text + offset), length)
+                    .Select(x => new TextRange((int)x.Offset, (int)x.Length)));
+                }
+                actual.AddRange(streamingSearch.Finish()
+                  .Select(x => new TextRange((int)x.Offset, (int)x.Length)));
+                CollectionAssert.AreEqual(expected, actual, string.Format("{0}: {1}", options, chunkSize));
+              }
+            }
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiStreamingSearchFindsWildcardMatchesOnLongLines() {
+      const int lineCount = 20;
+      // The entries are far apart on lines longer than the chunks, and
+      // longer than the context kept by default.
+      var line = new string('x', 1500) + "foo" + new string('x', 900) + "bar" + new string('x', 1500) + "\n";
+      var text = string.Concat(Enumerable.Repeat(line, lineCount));
+      using (var textBlock = HeapAllocStatic.Alloc(text.Length)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0; i < text.Length; i++) {
+          p[i] = (byte)text[i];
+        }
+
+        var options = NativeMethods.SearchOptions.kMatchCase;
+        using (var search = new AsciiCompiledTextSearchWildcard(new[] { "foo", "bar" }, options)) {
+          var fileFragment = new TextFragment(textBlock.Pointer, 0, text.Length, sizeof(byte));
+          var expected = search.FindAll(fileFragment, fileFragment, OperationProgressTracker.None).ToList();
+          Assert.AreEqual(lineCount, expected.Count);
+
+          foreach (var chunkSize in new[] { 7, 500, 4095 }) {
+            // The maximum match length is the length of the longest entry.
+            using (var streamingSearch = new AsciiStreamingTextSearch(search, options, 3)) {
+              var actual = new List<TextRange>();
+              for (var offset = 0; offset < text.Length; offset += chunkSize) {
+                var length = Math.Min(chunkSize, text.Length - offset);
+                actual.AddRange(streamingSearch.FeedChunk(new IntPtr(p + offset), length)
+                  .Select(x => new TextRange((int)x.Offset, (int)x.Length)));
+              }
+              actual.AddRange(streamingSearch.Finish()
+                .Select(x => new TextRange((int)x.Offset, (int)x.Length)));
+              CollectionAssert.AreEqual(expected, actual, chunkSize.ToString());
+            }
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiStreamingSearchMatchesWholeTextSearch() {
+      // Whole word matches, and wildcard matches missing entries, are
+      // candidates rejected by the search: the next chunk must not resume
+      // inside them.
+      var cases = new[] {
+        new { Kind = NativeMethods.SearchAlgorithmKind.kSimdLiteral, Pattern = "  ", Options = NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord },
+        new { Kind = NativeMethods.SearchAlgorithmKind.kStrStr, Pattern = "  ", Options = NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord },
+        new { Kind = NativeMethods.SearchAlgorithmKind.kSimdLiteral, Pattern = "aa", Options = NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord },
+        new { Kind = NativeMethods.SearchAlgorithmKind.kBoyerMoore, Pattern = "a a", Options = NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord },
+        new { Kind = NativeMethods.SearchAlgorithmKind.kTwoWay, Pattern = "aa", Options = NativeMethods.SearchOptions.kMatchWholeWord },
+        new { Kind = NativeMethods.SearchAlgorithmKind.kWildcard, Pattern = "aa\na", Options = NativeMethods.SearchOptions.kMatchCase },
+        new { Kind = NativeMethods.SearchAlgorithmKind.kWildcard, Pattern = "a\naa", Options = NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord },
+      };
+
+      // Short words and spaces, with a few line breaks, so that candidates
+      // are rejected all over the text.
+      var builder = new StringBuilder("ab   ");
+      var random = 1u;
+      for (var i = 0; i < 20000; i++) {
+        random = random * 1103515245 + 12345;
+        var r = (random >> 16) % 64;
+        builder.Append(r == 0 ? '\n' : r < 28 ? 'a' : r < 40 ? ' ' : r < 46 ? 'b' : r < 50 ? '_' : 'x');
+      }
+      var text = builder.ToString();
+
+      using (var textBlock = HeapAllocStatic.Alloc(text.Length)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0; i < text.Length; i++) {
+          p[i] = (byte)text[i];
+        }
+
+        foreach (var c in cases) {
+          var isWildcard = c.Kind == NativeMethods.SearchAlgorithmKind.kWildcard;
+          // The maximum match length of wildcard searches is the length of
+          // the longest entry.
+          var maxMatchLength = c.Pattern.Split('\n').Max(x => x.Length);
+          using (var search = new AsciiCompiledTextSearchNative(c.Kind, c.Pattern, c.Options))
+          using (var chunkSearch = new AsciiCompiledTextSearchNative(
+              c.Kind, c.Pattern, isWildcard ? c.Options : c.Options & ~NativeMethods.SearchOptions.kMatchWholeWord)) {
+            var streamingOptions = isWildcard ? c.Options & ~NativeMethods.SearchOptions.kMatchWholeWord : c.Options;
+            Func<int, Func<int, int>, List<TextRange>> findAll = (length, chunkSize) => {
+              using (var streamingSearch = new AsciiStreamingTextSearch(chunkSearch, streamingOptions, maxMatchLength)) {
+                var result = new List<TextRange>();
+                for (int offset = 0, index = 0; offset < length; index++) {
+                  var chunkLength = Math.Min(chunkSize(index), length - offset);
+                  result.AddRange(streamingSearch.FeedChunk(new IntPtr(p + offset), chunkLength)
+                    .Select(x => new TextRange((int)x.Offset, (int)x.Length)));
+                  offset += chunkLength;
+                }
+                result.AddRange(streamingSearch.Finish()
+                  .Select(x => new TextRange((int)x.Offset, (int)x.Length)));
+                return result;
+              }
+            };
+
+            // The text starts with "ab   ": fed as "ab" and "   ", the space
+            // pair starting at 2 is rejected, and the one at 3 must be too.
+            var expected = search.FindAll(
+              new TextFragment(textBlock.Pointer, 0, 5, sizeof(byte)),
+              x => x,
+              OperationProgressTracker.None).ToList();
+            CollectionAssert.AreEqual(expected, findAll(5, index => 2 + index % 2), c.Kind + ": short");
+
+            expected = search.FindAll(
+              new TextFragment(textBlock.Pointer, 0, text.Length, sizeof(byte)),
+              x => x,
+              OperationProgressTracker.None).ToList();
+            foreach (var chunkSize in new[] { 1, 7, 500, 4095 }) {
+              CollectionAssert.AreEqual(expected, findAll(text.Length, index => chunkSize), c.Kind + ": " + chunkSize);
+            }
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchFindAllFragmentsWorks() {
+      const int oneMB = 1024 * 1024;
+      const int fragmentLength = 4096;
+      const int matchCount = 1000;
+      const string pattern = "foo";
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        FillWithNonNulCharacters(textBlock);
+        SetSearchMatches(textBlock, pattern, matchCount);
+
+        // Split the block into small fragments, as with small files. Matches
+        // straddling two fragments are not found.
+        var fragments = new List<TextFragment>();
+        for (var position = 0L; position < textBlock.ByteLength; position += fragmentLength) {
+          var length = Math.Min(fragmentLength, textBlock.ByteLength - position);
+          fragments.Add(new TextFragment(textBlock.Pointer, (int)position, (int)length, sizeof(byte)));
+        }
+
+        using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, NativeMethods.SearchOptions.kMatchCase)) {
+          var expected = fragments
+            .Select(x => search.FindAll(x, y => y, OperationProgressTracker.None))
+            .ToList();
+          var sw = Stopwatch.StartNew();
+          var actual = search.FindAllFragments(fragments, OperationProgressTracker.None);
+          sw.Stop();
+          Trace.WriteLine(string.Format("  {0:n0} fragments searched in {1} s.", fragments.Count, sw.Elapsed.TotalSeconds));
+
+          Assert.AreEqual(expected.Count, actual.Length);
+          for (var i = 0; i < expected.Count; i++) {
+            CollectionAssert.AreEqual(expected[i].ToList(), actual[i].ToList());
+          }
+        }
+      }
+
+      // Fragments with more matches than a batch of matches (256), so that
+      // batches end in the middle of a fragment and the search resumes there.
+      const int matchesPerFragment = 300;
+      const int fragmentCount = 3;
+      var text = string.Concat(Enumerable.Repeat("foo ", matchesPerFragment * fragmentCount));
+      using (var textBlock = HeapAllocStatic.Alloc(text.Length)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0; i < text.Length; i++) {
+          p[i] = (byte)text[i];
+        }
+
+        var fragments = new List<TextFragment>();
+        for (var i = 0; i < fragmentCount; i++) {
+          fragments.Add(new TextFragment(textBlock.Pointer, i * matchesPerFragment * 4, matchesPerFragment * 4, sizeof(byte)));
+        }
+
+        using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, NativeMethods.SearchOptions.kMatchCase)) {
+          var actual = search.FindAllFragments(fragments, OperationProgressTracker.None);
+          Assert.AreEqual(fragmentCount, actual.Length);
+          for (var i = 0; i < fragmentCount; i++) {
+            CollectionAssert.AreEqual(
+              Enumerable.Range(0, matchesPerFragment)
+                .Select(x => new TextRange(fragments[i].Position + x * 4, pattern.Length))
+                .ToList(),
+              actual[i].ToList());
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchWildcardWorks() {
+      const string text = "foo bar\nbar foo\nfoo baz bar foo\nfoobar";
+      using (var textBlock = HeapAllocStatic.Alloc(text.Length)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0; i < text.Length; i++) {
+          p[i] = (byte)text[i];
+        }
+
+        using (var search = new AsciiCompiledTextSearchWildcard(new[] { "foo", "bar" }, NativeMethods.SearchOptions.kMatchCase)) {
+          var fileFragment = new TextFragment(textBlock.Pointer, 0, text.Length, sizeof(byte));
+          var matches = search.FindAll(fileFragment, fileFragment, OperationProgressTracker.None);
+          CollectionAssert.AreEqual(
+            new[] { new TextRange(0, 7), new TextRange(16, 11), new TextRange(32, 6) },
+            matches.ToList());
+
+          // Lines crossing the boundaries of the searched text are matched.
+          var textFragment = fileFragment.Sub(16, 4);
+          matches = search.FindAll(textFragment, fileFragment, OperationProgressTracker.None);
+          CollectionAssert.AreEqual(new[] { new TextRange(16, 11) }, matches.ToList());
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchPeriodicPatternWorks() {
+      const int tenMB = 10 * 1024 * 1024;
+      const int iterationCount = 2;
+      // Each run of '0' characters is one character shorter than the pattern,
+      // so that each position of the text is a partial match.
+      var pattern = new string('0', 100);
+
+      using (var textBlock = HeapAllocStatic.Alloc(tenMB)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0L; i < textBlock.ByteLength; i++) {
+          p[i] = (byte)((i % pattern.Length) == pattern.Length - 1 ? '1' : '0');
+        }
+
+        Trace.WriteLine(
+          string.Format(
+            "Searching {0} time(s) for periodic pattern of {1} characters in a memory block of {2:n0} bytes.",
+            iterationCount, pattern.Length, tenMB));
+        using (var search = new AsciiCompiledTextSearchTwoWay(pattern, NativeMethods.SearchOptions.kMatchCase)) {
+          MeasureSearch("Two-Way", textBlock, search, 0, iterationCount);
+        }
+        using (var search = new AsciiCompiledTextSearchSimdLiteral(pattern, NativeMethods.SearchOptions.kMatchCase)) {
+          MeasureSearch("SIMD literal", textBlock, search, 0, iterationCount);
+        }
+
+        // Matches are non overlapping, as with the other algorithms.
+        const string text = "0000000000100000";
+        for (var i = 0; i < text.Length; i++) {
+          p[i] = (byte)text[i];
+        }
+        using (var search = new AsciiCompiledTextSearchTwoWay("0000", NativeMethods.SearchOptions.kMatchCase)) {
+          var matches = search.FindAll(
+            new TextFragment(textBlock.Pointer, 0, text.Length, sizeof(byte)),
+            x => x,
+            OperationProgressTracker.None);
+          CollectionAssert.AreEqual(
+            new[] { new TextRange(0, 4), new TextRange(4, 4), new TextRange(11, 4) },
+            matches.ToList());
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchWholeWordWorks() {
+      const string text = "id width id_x id\n(id) idid";
+      const string pattern = "id";
+      using (var textBlock = HeapAllocStatic.Alloc(text.Length)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0; i < text.Length; i++) {
+          p[i] = (byte)text[i];
+        }
+
+        const NativeMethods.SearchOptions options =
+          NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord;
+        var searches = new AsciiCompiledTextSearchNative[] {
+          new AsciiCompiledTextSearchBndm32(pattern, options),
+          new AsciiCompiledTextSearchBndm64(pattern, options),
+          new AsciiCompiledTextSearchBndmLong(pattern, options),
+          new AsciiCompiledTextSearchBoyerMoore(pattern, options),
+          new AsciiCompiledTextSearchSimdLiteral(pattern, options),
+          new AsciiCompiledTextSearchStrStr(pattern, options),
+          new AsciiCompiledTextSearchTwoWay(pattern, options),
+        };
+        foreach (var search in searches) {
+          using (search) {
+            var matches = search.FindAll(
+              new TextFragment(textBlock.Pointer, 0, text.Length, sizeof(byte)),
+              x => x,
+              OperationProgressTracker.None);
+            CollectionAssert.AreEqual(
+              new[] { new TextRange(0, 2), new TextRange(14, 2), new TextRange(18, 2) },
+              matches.ToList(),
+              search.GetType().Name);
+          }
+        }
       }
     }
 
+    [TestMethod]
+    public unsafe void AsciiSearchPerHitOverhead() {
+      const int tenMB = 10 * 1024 * 1024;
+      const int iterationCount = 2;
+      // One whole word match every 2 characters, so that the time spent per
+      // match (i.e. calls from |FindAll| to the search kernel) dominates.
+      const string pattern = "a";
+      const int matchCount = tenMB / 2;
+
+      using (var textBlock = HeapAllocStatic.Alloc(tenMB)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0L; i < textBlock.ByteLength; i++) {
+          p[i] = (byte)((i % 2) == 0 ? 'a' : ' ');
+        }
+
+        Trace.WriteLine(
+          string.Format(
+            "Searching {0} time(s) for {1:n0} occurrence(s) of \"{2}\" in a memory block of {3:n0} bytes.",
+            iterationCount, matchCount, pattern, tenMB));
+        var optionsList = new[] {
+          NativeMethods.SearchOptions.kMatchCase,
+          NativeMethods.SearchOptions.kPerByteCaseFolding,
+          NativeMethods.SearchOptions.kMatchCase | NativeMethods.SearchOptions.kMatchWholeWord,
+        };
+        foreach (var options in optionsList) {
+          var searches = new AsciiCompiledTextSearchNative[] {
+            new AsciiCompiledTextSearchBndm32(pattern, options),
+            new AsciiCompiledTextSearchBndm64(pattern, options),
+            new AsciiCompiledTextSearchBoyerMoore(pattern, options),
+            new AsciiCompiledTextSearchSimdLiteral(pattern, options),
+            new AsciiCompiledTextSearchTwoWay(pattern, options),
+          };
+          foreach (var search in searches) {
+            using (search) {
+              var sw = Stopwatch.StartNew();
+              var count = PerformSearch(textBlock, search, iterationCount);
+              sw.Stop();
+              Assert.AreEqual(matchCount, count);
+              Trace.WriteLine(string.Format("  {0} {1}: {2:n2} ns per match.",
+                                            search.GetType().Name, options,
+                                            sw.Elapsed.TotalMilliseconds * 1000 * 1000 / ((double)matchCount * iterationCount)));
+            }
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchBestAlgorithmWorks() {
+      const int oneMB = 1024 * 1024;
+      const string pattern = "ee";
+
+      using (var textBlock = HeapAllocStatic.Alloc(oneMB)) {
+        var p = (byte*)textBlock.Pointer.ToPointer();
+        for (var i = 0L; i < textBlock.ByteLength; i++) {
+          p[i] = (byte)("the tree sees every bee\n"[(int)(i % 24)]);
+        }
+
+        // Loading a text file adds it to the sample the algorithms are
+        // timed on.
+        Assert.AreEqual(
+          NativeMethods.TextKind.TextKind_Ascii,
+          NativeMethods.Text_GetKind(textBlock.Pointer, (int)textBlock.ByteLength));
+
+        using (var search = AsciiCompiledTextSearchBest.Create(pattern, NativeMethods.SearchOptions.kMatchCase)) {
+          Trace.WriteLine(string.Format("Selected {0}: {1:n0} MB/s on {2:n0} bytes.",
+                                        search.Kind, search.BytesPerSecond / oneMB, search.SampleLength));
+          Assert.IsTrue(search.SampleLength > 0);
+          Assert.IsTrue(search.BytesPerSecond > 0);
+
+          var matches = search.FindAll(
+            new TextFragment(textBlock.Pointer, 0, 24, sizeof(byte)),
+            x => x,
+            OperationProgressTracker.None);
+          CollectionAssert.AreEqual(
+            new[] { new TextRange(6, 2), new TextRange(10, 2), new TextRange(21, 2) },
+            matches.ToList());
+        }
+
+        // The case insensitive BNDM and Boyer-Moore searches reject patterns
+        // this long: the other candidates are still timed and selected.
+        using (var search = AsciiCompiledTextSearchBest.Create(new string('e', 300), NativeMethods.SearchOptions.kNone)) {
+          Trace.WriteLine(string.Format("Selected {0} for a long pattern.", search.Kind));
+          Assert.IsTrue(search.SampleLength > 0);
+        }
+      }
+    }
+
+    [TestMethod]
+    public unsafe void AsciiSearchUtf8CaseFoldingWorks() {
+      var tests = new[] {
+        new { Pattern = "\u00C9T\u00C9", Text = "L'\u00E9t\u00E9, l'\u00C9T\u00C9, l'\u00C9t\u00E9",
+              Matches = new[] { new TextRange(2, 5), new TextRange(11, 5), new TextRange(20, 5) } },
+        // The Kelvin sign (3 bytes) folds to 'k' (1 byte).
+        new { Pattern = "\u212A", Text = "kK\u212A",
+              Matches = new[] { new TextRange(0, 1), new TextRange(1, 1), new TextRange(2, 3) } },
+        new { Pattern = "\u0394\u03B5\u03BB\u03C4\u03B1", Text = "\u0394\u0395\u039B\u03A4\u0391 \u03B4\u03B5\u03BB\u03C4\u03B1",
+              Matches = new[] { new TextRange(0, 10), new TextRange(11, 10) } },
+      };
+
+      foreach (var test in tests) {
+        var bytes = Encoding.UTF8.GetBytes(test.Text);
+        using (var textBlock = HeapAllocStatic.Alloc(bytes.Length)) {
+          Marshal.Copy(bytes, 0, textBlock.Pointer, bytes.Length);
+          using (var search = new AsciiCompiledTextSearchUtf8CaseFolding(test.Pattern, NativeMethods.SearchOptions.kNone)) {
+            var matches = search.FindAll(
+              new TextFragment(textBlock.Pointer, 0, bytes.Length, sizeof(byte)),
+              x => x,
+              OperationProgressTracker.None);
+            CollectionAssert.AreEqual(test.Matches, matches.ToList());
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void AsciiSearchApproximateWorks() {
+      var tests = new[] {
+        // "RenderFrameHot" is 1 deletion away, "RenderFrameHots" 2.
+        new { Pattern = "RenderFrameHost", MaxErrors = 1, Text = "RenderFrameHots RenderFramHost RenderFrameHost",
+              Matches = new[] { new TextRange(0, 14), new TextRange(16, 14), new TextRange(31, 15) } },
+        // Single character pieces: no filtering.
+        new { Pattern = "abc", MaxErrors = 2, Text = "xxxxaxcxx",
+              Matches = new[] { new TextRange(4, 3) } },
+        new { Pattern = "ptr", MaxErrors = 1, Text = "ptx ptr qtr",
+              Matches = new[] { new TextRange(0, 3), new TextRange(4, 3), new TextRange(8, 3) } },
+      };
+
+      foreach (var test in tests) {
+        using (var textBlock = HeapAllocStatic.Alloc(test.Text.Length)) {
+          var bytes = Encoding.ASCII.GetBytes(test.Text);
+          Marshal.Copy(bytes, 0, textBlock.Pointer, bytes.Length);
+          using (var search = new AsciiCompiledTextSearchApproximate(test.Pattern, test.MaxErrors, NativeMethods.SearchOptions.kMatchCase)) {
+            var matches = search.FindAll(
+              new TextFragment(textBlock.Pointer, 0, bytes.Length, sizeof(byte)),
+              x => x,
+              OperationProgressTracker.None);
+            CollectionAssert.AreEqual(test.Matches, matches.ToList(), test.Pattern);
+          }
+        }
+      }
+    }
+
+    [TestMethod]
+    public void Utf16SearchWorks() {
+      var kinds = new[] {
+        NativeMethods.SearchAlgorithmKind.kUtf16Bndm,
+        NativeMethods.SearchAlgorithmKind.kUtf16SimdLiteral,
+      };
+      var tests = new[] {
+        new { Pattern = "foo", Text = "foo Foo foobar xfoo", Options = NativeMethods.SearchOptions.kMatchCase,
+              Matches = new[] { new TextRange(0, 3), new TextRange(8, 3), new TextRange(16, 3) } },
+        new { Pattern = "foo", Text = "foo Foo foobar xfoo", Options = NativeMethods.SearchOptions.kMatchWholeWord,
+              Matches = new[] { new TextRange(0, 3), new TextRange(4, 3) } },
+        // Characters with the same low byte as the pattern characters.
+        new { Pattern = "\u00E9t\u00E9", Text = "\u01E9t\u01E9 \u00E9t\u00E9 \u00E9T\u00E9 \u00C9t\u00E9", Options = NativeMethods.SearchOptions.kNone,
+              Matches = new[] { new TextRange(4, 3), new TextRange(8, 3) } },
+        new { Pattern = "\u4E2D\u6587", Text = "\u4E2D\u6587\u4E2D\u4E2D\u6587", Options = NativeMethods.SearchOptions.kMatchCase,
+              Matches = new[] { new TextRange(0, 2), new TextRange(3, 2) } },
+      };
+
+      foreach (var kind in kinds) {
+        foreach (var test in tests) {
+          using (var textBlock = HeapAllocStatic.Alloc(test.Text.Length * sizeof(char))) {
+            Marshal.Copy(test.Text.ToCharArray(), 0, textBlock.Pointer, test.Text.Length);
+            using (var search = new Utf16CompiledTextSearchNative(kind, test.Pattern, test.Options)) {
+              var matches = search.FindAll(
+                new TextFragment(textBlock.Pointer, 0, test.Text.Length, sizeof(char)),
+                x => x,
+                OperationProgressTracker.None);
+              CollectionAssert.AreEqual(test.Matches, matches.ToList(), string.Format("{0}: {1}", kind, test.Pattern));
+            }
+          }
+        }
+      }
+    }
+
+    private void MeasureSearch(
+        string name,
+        SafeHeapBlockHandle textBlock,
+        ICompiledTextSearch search,
+        int expectedMatchCount,
+        int iterationCount) {
+      var sw = Stopwatch.StartNew();
+      var matchCount = PerformSearch(textBlock, search, iterationCount);
+      sw.Stop();
+      Assert.AreEqual(expectedMatchCount, matchCount);
+      Trace.WriteLine(string.Format("  {0}: Found {1:n0} occurrence(s) {2} times in {3} s ({4:n0} KB/s.)",
+                                    name, matchCount, iterationCount, sw.Elapsed.TotalSeconds,
+                                    ComputeThroughput(sw, textBlock.ByteLength, iterationCount)));
+    }
+
     private double ComputeThroughput(Stopwatch sw, long size, int repeat) {
       var kbytes = (size * repeat) / 1024L;
       var s = sw.Elapsed.TotalSeconds;
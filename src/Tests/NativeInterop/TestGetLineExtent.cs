@@ -67,6 +67,18 @@ namespace VsChromium.Tests.NativeInterop {
         out length);
       Assert.AreEqual(expectedOffset, offset);
       Assert.AreEqual(expectedLength, length);
+
+      long offset64;
+      long length64;
+      NativeMethods.Ascii_GetLineExtentFromPosition64(
+        mem.Ptr,
+        mem.Size - 1,
+        position,
+        maxLength,
+        out offset64,
+        out length64);
+      Assert.AreEqual((long)expectedOffset, offset64);
+      Assert.AreEqual((long)expectedLength, length64);
     }
 
     public static MemoryBlock CreateAsciiMemory(string text) {
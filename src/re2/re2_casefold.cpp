@@ -0,0 +1,29 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "re2_casefold.h"
+
+#include "re2/unicode_casefold.h"
+
+int RE2CaseFoldRune(int rune) {
+  // Orbits have at most 4 runes (e.g. U+0398, U+03B8, U+03D1 and U+03F4),
+  // each of them mapped to the next one by |unicode_casefold|.
+  int result = rune;
+  int current = rune;
+  while (true) {
+    re2::CaseFold* fold = re2::LookupCaseFold(
+        re2::unicode_casefold, re2::num_unicode_casefold, current);
+    if (fold == nullptr || current < static_cast<int>(fold->lo))
+      break;
+    current = re2::ApplyFold(fold, current);
+    if (current == rune)
+      break;
+    if (current < result)
+      result = current;
+  }
+
+  if (result >= 'A' && result <= 'Z')
+    result += 'a' - 'A';
+  return result;
+}
@@ -0,0 +1,12 @@
+// Copyright 2020 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+// Returns the representative of the Unicode simple case folding orbit of
+// |rune| (e.g. 'k' for 'K', 'k' and the Kelvin sign), using the case folding
+// tables of RE2. The representative is the smallest rune of the orbit, except
+// that ASCII upper case letters are converted to lower case, so that ASCII
+// text folds the same as with |AsciiFoldToLower|.
+int RE2CaseFoldRune(int rune);
@@ -4,7 +4,152 @@
 
 #include "re2_wrapper.h"
 
+#include "re2/prefilter.h"
 #include "re2/re2.h"
+#include "re2/regexp.h"
+#include "re2/walker-inl.h"
+
+namespace {
+
+// Maximum number of alternative atoms returned by |GetRequiredAtoms|.
+const size_t kMaxAtoms = 16;
+
+// Properties of a regular expression, computed by |PropertiesWalker|.
+enum RegexpProperties {
+  kMatchesNewline = 1 << 0,
+  // re2::Prefilter lower cases the Kelvin sign (U+212A) to "k", and the long
+  // s (U+017F) to "s", which a search ignoring ASCII case does not find.
+  kMatchesKelvinSign = 1 << 1,
+  kMatchesLongS = 1 << 2,
+  kAllProperties = kMatchesNewline | kMatchesKelvinSign | kMatchesLongS,
+};
+
+int RuneProperties(re2::Rune rune, bool foldCase) {
+  int result = 0;
+  if (rune == '\n')
+    result |= kMatchesNewline;
+  if (rune == 0x212A || (foldCase && (rune == 'k' || rune == 'K')))
+    result |= kMatchesKelvinSign;
+  if (rune == 0x17F || (foldCase && (rune == 's' || rune == 'S')))
+    result |= kMatchesLongS;
+  return result;
+}
+
+class PropertiesWalker : public re2::Regexp::Walker<int> {
+ public:
+  virtual int PostVisit(re2::Regexp* re, int parentArg, int preArg, int* childArgs, int childArgCount) {
+    int result = 0;
+    for (int i = 0; i < childArgCount; i++) {
+      result |= childArgs[i];
+    }
+
+    bool foldCase = (re->parse_flags() & re2::Regexp::FoldCase) != 0;
+    switch (re->op()) {
+      case re2::kRegexpLiteral:
+        result |= RuneProperties(re->rune(), foldCase);
+        break;
+      case re2::kRegexpLiteralString:
+        for (int i = 0; i < re->nrunes(); i++) {
+          result |= RuneProperties(re->runes()[i], foldCase);
+        }
+        break;
+      case re2::kRegexpCharClass:
+        if (re->cc()->Contains('\n'))
+          result |= kMatchesNewline;
+        if (re->cc()->Contains(0x212A))
+          result |= kMatchesKelvinSign;
+        if (re->cc()->Contains(0x17F))
+          result |= kMatchesLongS;
+        break;
+      case re2::kRegexpAnyChar:
+      case re2::kRegexpAnyByte:
+        result |= kMatchesNewline;
+        break;
+    }
+    return result;
+  }
+
+  virtual int ShortVisit(re2::Regexp* re, int parentArg) {
+    return kAllProperties;
+  }
+};
+
+bool IsUsableAtom(const std::string& atom, int minAtomLength, int properties) {
+  if (static_cast<int>(atom.size()) < minAtomLength)
+    return false;
+  for (size_t i = 0; i < atom.size(); i++) {
+    unsigned char ch = atom[i];
+    if (ch >= 0x80 || ch == '\n')
+      return false;
+    if (ch == 'k' && (properties & kMatchesKelvinSign))
+      return false;
+    if (ch == 's' && (properties & kMatchesLongS))
+      return false;
+  }
+  return true;
+}
+
+size_t GetShortestAtomLength(const std::vector<std::string>& atoms) {
+  size_t result = atoms[0].size();
+  for (size_t i = 1; i < atoms.size(); i++) {
+    if (atoms[i].size() < result)
+      result = atoms[i].size();
+  }
+  return result;
+}
+
+// Stores in |atoms| the strings of |prefilter| one of which is in every
+// match, and returns false if there is no usable set of such strings.
+bool GetPrefilterAtoms(re2::Prefilter* prefilter, int minAtomLength, int properties, std::vector<std::string>* atoms) {
+  switch (prefilter->op()) {
+    case re2::Prefilter::ATOM:
+      if (!IsUsableAtom(prefilter->atom(), minAtomLength, properties))
+        return false;
+      atoms->assign(1, prefilter->atom());
+      return true;
+
+    case re2::Prefilter::OR: {
+      // All the alternatives must be usable.
+      std::vector<std::string> result;
+      for (re2::Prefilter* sub : *prefilter->subs()) {
+        std::vector<std::string> subAtoms;
+        if (!GetPrefilterAtoms(sub, minAtomLength, properties, &subAtoms))
+          return false;
+        result.insert(result.end(), subAtoms.begin(), subAtoms.end());
+        if (result.size() > kMaxAtoms)
+          return false;
+      }
+      atoms->swap(result);
+      return !atoms->empty();
+    }
+
+    case re2::Prefilter::AND: {
+      // Any of the parts will do: keep the one with the longest atoms, which
+      // are likely to be the least frequent ones, then with the fewest atoms.
+      bool found = false;
+      for (re2::Prefilter* sub : *prefilter->subs()) {
+        std::vector<std::string> subAtoms;
+        if (!GetPrefilterAtoms(sub, minAtomLength, properties, &subAtoms))
+          continue;
+        if (found) {
+          size_t length = GetShortestAtomLength(subAtoms);
+          size_t bestLength = GetShortestAtomLength(*atoms);
+          if (length < bestLength || (length == bestLength && subAtoms.size() >= atoms->size()))
+            continue;
+        }
+        atoms->swap(subAtoms);
+        found = true;
+      }
+      return found;
+    }
+
+    default:
+      // ALL and NONE
+      return false;
+  }
+}
+
+}  // namespace
 
 class RE2WrapperImpl {
 public:
@@ -30,12 +175,15 @@ void RE2Wrapper::Compile(
     const char *pattern,
     int patternLen,
     bool caseSensitive,
+    bool latin1,
     std::string* error) {
   pattern_ = pattern;
   patternLen_ = patternLen;
 
   re2::RE2::Options options;
   options.set_case_sensitive(caseSensitive);
+  if (latin1)
+    options.set_encoding(re2::RE2::Options::EncodingLatin1);
   re2::StringPiece patternPiece(pattern, patternLen);
   RE2* re2 = new re2::RE2(patternPiece, options);
   if (re2 == nullptr) {
@@ -69,3 +217,49 @@ void RE2Wrapper::Match(
   (*matchStart) = match.data();
   (*matchLength) = match.length();
 }
+
+int RE2Wrapper::MatchAll(
+    const char* textStart,
+    int textLength,
+    int startPosition,
+    int endPosition,
+    MatchPosition* matches,
+    int capacity) {
+  // Asking for the extent of the whole match only (no capturing group)
+  // lets RE2 find it with the forward DFA (for its end) then the DFA of the
+  // reversed program (for its start), instead of falling back to the NFA.
+  // The DFA states cached by the first call are reused by the next ones.
+  re2::StringPiece text(textStart, textLength);
+  re2::StringPiece match;
+  int position = startPosition;
+  int count = 0;
+  while (count < capacity && position <= endPosition) {
+    if (!impl_->regex_->Match(text, position, endPosition, RE2::UNANCHORED, &match, 1))
+      break;
+
+    int offset = static_cast<int>(match.data() - textStart);
+    matches[count].Offset = offset;
+    matches[count].Length = match.length();
+    count++;
+    position = offset + (match.length() == 0 ? 1 : match.length());
+  }
+  return count;
+}
+
+void RE2Wrapper::GetRequiredAtoms(int minAtomLength, std::vector<std::string>* atoms) {
+  atoms->clear();
+  re2::Prefilter* prefilter = re2::Prefilter::FromRE2(impl_->regex_);
+  if (prefilter == nullptr)
+    return;
+
+  PropertiesWalker walker;
+  int properties = walker.Walk(impl_->regex_->Regexp(), 0);
+  if (!GetPrefilterAtoms(prefilter, minAtomLength, properties, atoms))
+    atoms->clear();
+  delete prefilter;
+}
+
+bool RE2Wrapper::CanMatchNewline() {
+  PropertiesWalker walker;
+  return (walker.Walk(impl_->regex_->Regexp(), 0) & kMatchesNewline) != 0;
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 class RE2WrapperImpl;
 
@@ -13,9 +14,34 @@ class RE2Wrapper {
   RE2Wrapper();
   ~RE2Wrapper();
 
-  void Compile(const char *pattern, int patternLen, bool caseSensitive, std::string* error);
+  // |latin1| compiles the pattern to match bytes (as std::regex does)
+  // instead of UTF-8 characters.
+  void Compile(const char *pattern, int patternLen, bool caseSensitive, bool latin1, std::string* error);
   void Match(const char* textStart, int textLength, const char** matchStart, int* matchLength);
 
+  // A match found by |MatchAll|, relative to the start of the text.
+  struct MatchPosition {
+    int Offset;
+    int Length;
+  };
+  // Stores the matches found in the |textLength| characters at |textStart|,
+  // between |startPosition| and |endPosition|, into |matches| until
+  // |endPosition| is reached or |capacity| matches have been stored, and
+  // returns the number of matches stored. Matches do not overlap: each match
+  // is searched from the end of the previous one (or the next character if
+  // it is empty). The characters outside of the range are only used as
+  // context, e.g. for "^" or "\b".
+  int MatchAll(const char* textStart, int textLength, int startPosition, int endPosition, MatchPosition* matches, int capacity);
+
+  // Stores in |atoms| literal strings, in lower case, such that every match
+  // of the pattern contains one of them when ignoring ASCII case. The
+  // strings are extracted with re2::Prefilter, and have at least
+  // |minAtomLength| ASCII characters. |atoms| is left empty if the pattern
+  // has no such set of strings.
+  void GetRequiredAtoms(int minAtomLength, std::vector<std::string>* atoms);
+  // Returns true if a match of the pattern may contain a newline.
+  bool CanMatchNewline();
+
  private:
   const char *pattern_;
   int patternLen_;